@@ -0,0 +1,126 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Run a three stage pipeline over a BroadcastRing.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "broadcast_ring.h"
+
+namespace {
+
+const int kPerProducer = 50000;
+
+struct Event {
+  int producer;
+  int seq;
+  int64_t doubled;
+};
+
+// Tracks per producer order for one consumer
+class OrderCheck {
+ public:
+  explicit OrderCheck(int producers) : next_(producers, 0) {}
+
+  void See(const Event& event) {
+    in_order_ = in_order_ && event.seq == next_[event.producer];
+    next_[event.producer]++;
+    count_++;
+  }
+
+  bool Passed(int expected) const { return in_order_ && count_ == expected; }
+
+ private:
+  std::vector<int> next_;
+  int count_{0};
+  bool in_order_{true};
+};
+
+// A journal reads every event, an enricher fills in 'doubled' in place and
+// the logic stage, gated on both, must see the enriched value. With two
+// producers one publishes by copy and the other claims slots in place.
+bool Pipeline(Utils::ProducerMode mode, Utils::WaitStrategy strategy,
+              const std::string& name) {
+  const int producers = mode == Utils::ProducerMode::kMulti ? 2 : 1;
+  const int total = producers * kPerProducer;
+  Utils::BroadcastRing<Event> ring(64, mode, strategy);
+  size_t journal = ring.AddConsumer();
+  size_t enricher = ring.AddConsumer();
+  size_t logic = ring.AddConsumer({journal, enricher});
+
+  OrderCheck journal_check(producers);
+  OrderCheck logic_check(producers);
+  bool enriched = true;
+  std::vector<std::thread> threads;
+  threads.emplace_back([&] {
+    Event event;
+    while (ring.WaitAndRead(journal, event)) {
+      journal_check.See(event);
+    }
+  });
+  threads.emplace_back([&] {
+    while (ring.Process(enricher, [](Event& event) {
+      event.doubled = 2 * static_cast<int64_t>(event.seq);
+    }, 16) > 0) {
+    }
+  });
+  threads.emplace_back([&] {
+    while (ring.Process(logic, [&](Event& event) {
+      enriched = enriched && event.doubled == 2 * event.seq;
+      logic_check.See(event);
+    }) > 0) {
+    }
+  });
+
+  std::vector<std::thread> publishers;
+  for (int p = 0; p < producers; p++) {
+    publishers.emplace_back([&ring, p] {
+      for (int i = 0; i < kPerProducer; i++) {
+        if (p == 0) {
+          ring.Publish(Event{p, i, -1});
+          continue;
+        }
+        int64_t sequence = ring.Claim();
+        ring.At(sequence) = Event{p, i, -1};
+        ring.Commit(sequence);
+      }
+    });
+  }
+  for (auto &thread : publishers) {
+    thread.join();
+  }
+  ring.Close();
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  std::cout << name << ": " << total << " events through three stages"
+            << std::endl;
+  if (!journal_check.Passed(total) || !logic_check.Passed(total) ||
+      !enriched) {
+    std::cerr << "FAILED, " << name << " lost, reordered or skipped a stage"
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  if (!Pipeline(Utils::ProducerMode::kSingle, Utils::WaitStrategy::kBlocking,
+                "single producer, blocking") ||
+      !Pipeline(Utils::ProducerMode::kMulti,
+                Utils::WaitStrategy::kSpinThenPark,
+                "two producers, spin then park")) {
+    return 1;
+  }
+  std::cout << "ok" << std::endl;
+  return 0;
+}
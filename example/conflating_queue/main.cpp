@@ -0,0 +1,98 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Conflate fast updates for a fixed set of keys into a slow consumer.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "conflating_queue.h"
+
+namespace {
+
+bool Check(bool ok, const std::string& what) {
+  if (!ok) {
+    std::cerr << "FAILED, " << what << std::endl;
+  }
+  return ok;
+}
+
+// A key still queued keeps its place and takes the latest value.
+bool Replace() {
+  Utils::ConflatingQueue<std::string, int> queue;
+  queue.Push("a", 1);
+  queue.Push("b", 1);
+  queue.Push("a", 2);
+  std::vector<std::pair<std::string, int> > out;
+  queue.PopAll(out);
+  std::vector<std::pair<std::string, int> > expected = {{"a", 2}, {"b", 1}};
+  return Check(out == expected, "updates not conflated in arrival order");
+}
+
+// Producers own disjoint keys and push rising versions. The consumer must
+// see the versions of a key rise and end on the last one pushed, while
+// popping far fewer updates than were pushed.
+bool Conflate() {
+  const int kProducers = 3;
+  const int kKeys = 10;
+  const int kVersions = 20000;
+  Utils::ConflatingQueue<std::string, int> queue;
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; p++) {
+    producers.emplace_back([&queue, p] {
+      for (int version = 1; version <= kVersions; version++) {
+        for (int k = 0; k < kKeys; k++) {
+          queue.Push(std::to_string(p) + "-" + std::to_string(k), version);
+        }
+      }
+    });
+  }
+  std::thread closer([&producers, &queue] {
+    for (auto &thread : producers) {
+      thread.join();
+    }
+    queue.Close();
+  });
+
+  std::map<std::string, int> latest;
+  bool rising = true;
+  size_t popped = 0;
+  std::vector<std::pair<std::string, int> > updates;
+  while (queue.WaitAndPopAll(updates) > 0) {
+    for (const auto &update : updates) {
+      rising = rising && update.second > latest[update.first];
+      latest[update.first] = update.second;
+    }
+    popped += updates.size();
+    updates.clear();
+    // A slow consumer, so updates pile up and conflate
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+  closer.join();
+
+  bool complete = latest.size() == kProducers * kKeys;
+  for (const auto &entry : latest) {
+    complete = complete && entry.second == kVersions;
+  }
+  std::cout << "conflate: " << kProducers * kKeys * kVersions
+            << " pushes, " << popped << " pops" << std::endl;
+  return Check(rising, "versions of a key went backwards") &&
+         Check(complete, "a key did not end on its last version");
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  if (!Replace() || !Conflate()) {
+    return 1;
+  }
+  std::cout << "ok" << std::endl;
+  return 0;
+}
@@ -0,0 +1,144 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Exercise ThreadSafeDelayQueue with several producers and consumers.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "thread_safe_delay_queue.h"
+
+namespace {
+
+typedef Utils::ThreadSafeDelayQueue<int>::Clock Clock;
+
+struct Delayed {
+  Clock::time_point due;
+  int id;
+};
+
+bool Check(bool ok, const std::string& what) {
+  if (!ok) {
+    std::cerr << "FAILED, " << what << std::endl;
+  }
+  return ok;
+}
+
+// Producers push with delays in random order while consumers pop through
+// the blocking, batch and timed calls. Nothing may come out before it is
+// due.
+bool Delays() {
+  Utils::ThreadSafeDelayQueue<Delayed> queue;
+  const int kPerProducer = 2000;
+  std::atomic<int> popped{0};
+  std::atomic<int> early{0};
+
+  std::vector<std::thread> consumers;
+  for (int c = 0; c < 3; c++) {
+    consumers.emplace_back([&, c] {
+      Delayed item;
+      std::vector<Delayed> batch;
+      while (true) {
+        batch.clear();
+        if (c == 0) {
+          if (!queue.WaitAndPop(item)) {
+            return;
+          }
+          batch.push_back(item);
+        } else if (c == 1) {
+          if (queue.WaitAndPopAllDue(batch) == 0) {
+            return;
+          }
+        } else {
+          Utils::QueueStatus status =
+              queue.WaitAndPopFor(item, std::chrono::milliseconds(5));
+          if (status == Utils::QueueStatus::kClosed) {
+            return;
+          }
+          if (status == Utils::QueueStatus::kSuccess) {
+            batch.push_back(item);
+          }
+        }
+        Clock::time_point now = Clock::now();
+        for (const Delayed& entry : batch) {
+          early += now < entry.due ? 1 : 0;
+        }
+        popped += static_cast<int>(batch.size());
+      }
+    });
+  }
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < 2; p++) {
+    producers.emplace_back([&queue, p] {
+      unsigned seed = p + 1;
+      for (int i = 0; i < kPerProducer; i++) {
+        seed = seed * 1103515245u + 12345u;
+        Clock::time_point due =
+            Clock::now() + std::chrono::milliseconds((seed >> 8) % 30);
+        queue.PushAt(Delayed{due, i}, due);
+      }
+    });
+  }
+  for (auto &thread : producers) {
+    thread.join();
+  }
+  auto deadline = Clock::now() + std::chrono::seconds(5);
+  while (popped < 2 * kPerProducer && Clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  int popped_before_close = popped;
+  queue.Close();
+  for (auto &thread : consumers) {
+    thread.join();
+  }
+  std::cout << "delays: " << popped_before_close << " popped when due"
+            << std::endl;
+  return Check(popped_before_close == 2 * kPerProducer,
+               "due elements not handed out") &&
+         Check(early == 0, "elements popped before they were due");
+}
+
+// Equal due times keep push order, and Close() hands out elements that
+// are not due yet.
+bool OrderAndClose() {
+  Utils::ThreadSafeDelayQueue<int> queue;
+  Clock::time_point due = Clock::now() + std::chrono::milliseconds(5);
+  for (int i = 1; i <= 5; i++) {
+    queue.PushAt(i, due);
+  }
+  std::vector<int> out;
+  queue.WaitAndPopAllDue(out);
+  if (!Check(out == std::vector<int>({1, 2, 3, 4, 5}),
+             "equal due times not popped in push order")) {
+    return false;
+  }
+
+  queue.Push(6, std::chrono::seconds(10));
+  int value = 0;
+  if (!Check(!queue.TryPop(value), "popped an element before it was due")) {
+    return false;
+  }
+  queue.Close();
+  bool drained = queue.WaitAndPop(value) && value == 6;
+  return Check(drained && !queue.WaitAndPop(value),
+               "close did not drain pending elements") &&
+         Check(!queue.Push(7, std::chrono::milliseconds(0)),
+               "push after close accepted");
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  if (!Delays() || !OrderAndClose()) {
+    return 1;
+  }
+  std::cout << "ok" << std::endl;
+  return 0;
+}
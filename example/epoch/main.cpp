@@ -0,0 +1,97 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Stress Epoch: readers follow a pointer that writers keep replacing.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "epoch.h"
+
+namespace {
+
+const uint64_t kAlive = 0x600DF00D;
+
+struct Node {
+  std::atomic<uint64_t> magic{0};
+  std::atomic<uint64_t> version{0};
+
+  // Called by MemPoolEx on release, a reader still holding the node would
+  // see it dead
+  void Reset() { magic.store(0, std::memory_order_relaxed); }
+};
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  const int kReaders = 4;
+  const int kWriters = 2;
+  const int kUpdates = 20000;
+
+  // Pooled nodes stay mapped after reclaim, so an early reclaim shows up as
+  // a dead or reused node instead of a crash
+  auto pool = Utils::MemPoolEx<Node>::Create(64, 0);
+  std::atomic<uint64_t> next_version{1};
+  Node *first = pool->GetEx();
+  first->version.store(next_version++);
+  first->magic.store(kAlive);
+  std::atomic<Node *> current{first};
+
+  std::atomic<bool> stop{false};
+  std::atomic<uint64_t> reads{0};
+  std::atomic<uint64_t> errors{0};
+  std::vector<std::thread> readers;
+  for (int r = 0; r < kReaders; r++) {
+    readers.emplace_back([&] {
+      while (!stop.load(std::memory_order_relaxed)) {
+        Utils::Epoch::Guard guard;
+        Node *node = current.load(std::memory_order_acquire);
+        uint64_t version = node->version.load(std::memory_order_relaxed);
+        std::this_thread::yield();
+        if (node->magic.load(std::memory_order_relaxed) != kAlive ||
+            node->version.load(std::memory_order_relaxed) != version) {
+          errors++;
+        }
+        reads++;
+      }
+    });
+  }
+
+  std::vector<std::thread> writers;
+  for (int w = 0; w < kWriters; w++) {
+    writers.emplace_back([&] {
+      for (int i = 0; i < kUpdates; i++) {
+        Node *node = pool->GetEx();
+        node->version.store(next_version++, std::memory_order_relaxed);
+        node->magic.store(kAlive, std::memory_order_relaxed);
+        Node *old = current.exchange(node, std::memory_order_acq_rel);
+        Utils::Epoch::Retire(old, pool);
+      }
+      Utils::Epoch::Synchronize();
+    });
+  }
+  for (auto &writer : writers) {
+    writer.join();
+  }
+  stop = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+
+  std::cout << "reads " << reads << ", epoch " << Utils::Epoch::GetGlobalEpoch()
+            << ", nodes allocated " << pool->GetAllocatedCount() << ", in use "
+            << pool->GetUsedCount() << std::endl;
+  if (errors > 0 || pool->GetUsedCount() != 1) {
+    std::cerr << "FAILED, " << errors << " reads of reclaimed nodes"
+              << std::endl;
+    return 1;
+  }
+  std::cout << "ok" << std::endl;
+  return 0;
+}
@@ -0,0 +1,97 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Exercise MemPoolEx from several threads, bounded and unbounded.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "mempool.h"
+
+namespace {
+
+struct Buffer {
+  int owner{-1};
+  char data[64];
+
+  void Reset() { owner = -1; }
+};
+
+bool Check(bool ok, const char *what) {
+  if (!ok) {
+    std::cerr << "FAILED: " << what << std::endl;
+  }
+  return ok;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  bool ok = true;
+
+  // Bounded: the pool never grows past 'max_alloc'
+  auto bounded = Utils::MemPoolEx<Buffer>::Create(2, 4);
+  std::vector<Buffer *> taken;
+  Buffer *item;
+  while ((item = bounded->GetEx()) != nullptr) {
+    taken.push_back(item);
+  }
+  ok &= Check(taken.size() == 4, "bounded pool hands out max_alloc items");
+  // A second or foreign release is ignored
+  bounded->Release(taken[0]);
+  bounded->Release(taken[0]);
+  Buffer foreign;
+  bounded->Release(&foreign);
+  ok &= Check(bounded->GetUsedCount() == 3, "double release is ignored");
+  ok &= Check(bounded->GetEx() == taken[0], "released item is reused");
+  ok &= Check(bounded->GetEx() == nullptr, "no item is handed out twice");
+  for (auto buffer : taken) {
+    bounded->Release(buffer);
+  }
+
+  // Unbounded, shared by threads that hold a few items at a time
+  auto pool = Utils::MemPoolEx<Buffer>::Create(16, 0);
+  std::atomic<int> clashes{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&pool, &clashes, t] {
+      for (int i = 0; i < 20000; i++) {
+        Buffer *held[4];
+        for (auto &buffer : held) {
+          buffer = pool->GetEx();
+          if (buffer->owner != -1) {
+            clashes++;
+          }
+          buffer->owner = t;
+        }
+        for (auto buffer : held) {
+          if (buffer->owner != t) {
+            clashes++;
+          }
+          pool->Release(buffer);
+        }
+        // Auto released through the pool's deleter
+        std::shared_ptr<Buffer> shared = pool->GetSharedPtrEx(true);
+        shared->owner = t;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  std::cout << "allocated " << pool->GetAllocatedCount() << ", free "
+            << pool->GetFreeCount() << std::endl;
+  ok &= Check(clashes == 0, "no item is shared between threads");
+  ok &= Check(pool->GetUsedCount() == 0, "every item is back in the pool");
+
+  if (!ok) {
+    return 1;
+  }
+  std::cout << "ok" << std::endl;
+  return 0;
+}
@@ -0,0 +1,75 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Stress BoundedMpmcQueue with a ring small enough to fill up.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "bounded_mpmc_queue.h"
+
+int main(int argc, char *argv[]) {
+  const int kProducers = 3;
+  const int kConsumers = 3;
+  const int kPerProducer = 100000;
+
+  // Eight slots keep producers on the full path and consumers on the empty
+  // path most of the time
+  Utils::BoundedMpmcQueue<uint64_t> queue(8);
+  std::atomic<uint64_t> sum{0};
+  std::atomic<int> popped{0};
+  std::atomic<int> full_retries{0};
+
+  std::vector<std::thread> threads;
+  for (int p = 0; p < kProducers; p++) {
+    threads.emplace_back([&, p] {
+      for (int i = 1; i <= kPerProducer; i++) {
+        uint64_t value = static_cast<uint64_t>(i);
+        // Half of the values through the non-blocking call
+        if (p % 2 == 0) {
+          queue.Push(value);
+          continue;
+        }
+        while (!queue.TryPush(value)) {
+          full_retries++;
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  const int total = kProducers * kPerProducer;
+  for (int c = 0; c < kConsumers; c++) {
+    threads.emplace_back([&, c] {
+      uint64_t value;
+      while (popped.fetch_add(1) < total) {
+        if (c == 0) {
+          queue.WaitAndPop(value);
+        } else {
+          while (!queue.TryPop(value)) {
+            std::this_thread::yield();
+          }
+        }
+        sum += value;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  uint64_t expected = static_cast<uint64_t>(kProducers) * kPerProducer *
+                      (kPerProducer + 1) / 2;
+  std::cout << "sum " << sum << ", full retries " << full_retries
+            << std::endl;
+  if (sum != expected || !queue.IsEmpty()) {
+    std::cerr << "FAILED, expected sum " << expected << std::endl;
+    return 1;
+  }
+  std::cout << "ok" << std::endl;
+  return 0;
+}
@@ -0,0 +1,115 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Feed the MPSC queues from several producers into one consumer.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mpsc_queue.h"
+
+namespace {
+
+const int kProducers = 3;
+const int kPerProducer = 50000;
+
+struct Message : public Utils::MpscHook {
+  int producer;
+  int seq;
+};
+
+bool Check(bool ok, const std::string& what) {
+  if (!ok) {
+    std::cerr << "FAILED, " << what << std::endl;
+  }
+  return ok;
+}
+
+// An actor style mailbox: producers push messages they own, the consumer
+// parks between bursts. Each producer's messages must arrive in order.
+bool Mailbox() {
+  Utils::IntrusiveMpscQueue<Message> mailbox(true);
+  std::vector<std::vector<Message>> messages(
+      kProducers, std::vector<Message>(kPerProducer));
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; p++) {
+    producers.emplace_back([&mailbox, &messages, p] {
+      for (int i = 0; i < kPerProducer; i++) {
+        messages[p][i].producer = p;
+        messages[p][i].seq = i;
+        mailbox.Push(&messages[p][i]);
+        if (i % 10000 == 0) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+      }
+    });
+  }
+
+  std::vector<int> next(kProducers, 0);
+  bool in_order = true;
+  for (int i = 0; i < kProducers * kPerProducer; i++) {
+    Message* message = mailbox.WaitAndPop();
+    in_order = in_order && message->seq == next[message->producer];
+    next[message->producer]++;
+  }
+  for (auto &thread : producers) {
+    thread.join();
+  }
+  std::cout << "mailbox: " << kProducers * kPerProducer << " messages"
+            << std::endl;
+  return Check(in_order && mailbox.IsEmpty(),
+               "mailbox lost or reordered messages");
+}
+
+// Value queue with a slab smaller than the backlog, so pushes take pooled
+// nodes and fall back to new, and without a slab in blocking mode.
+bool Values(int pre_alloc, bool blocking) {
+  Utils::MpscQueue<std::string> queue(pre_alloc, blocking);
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; p++) {
+    producers.emplace_back([&queue, p] {
+      for (int i = 0; i < kPerProducer; i++) {
+        queue.Push(std::to_string(p) + ":" + std::to_string(i));
+      }
+    });
+  }
+
+  std::vector<int> next(kProducers, 0);
+  bool in_order = true;
+  std::string value;
+  for (int i = 0; i < kProducers * kPerProducer; i++) {
+    if (blocking) {
+      queue.WaitAndPop(value);
+    } else {
+      while (!queue.TryPop(value)) {
+        std::this_thread::yield();
+      }
+    }
+    size_t colon = value.find(':');
+    int p = std::stoi(value.substr(0, colon));
+    in_order = in_order && std::stoi(value.substr(colon + 1)) == next[p];
+    next[p]++;
+  }
+  for (auto &thread : producers) {
+    thread.join();
+  }
+  std::cout << "values, pre_alloc " << pre_alloc
+            << (blocking ? ", blocking" : ", spinning") << std::endl;
+  return Check(in_order && queue.IsEmpty(),
+               "value queue lost or reordered values");
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  if (!Mailbox() || !Values(64, false) || !Values(0, true)) {
+    return 1;
+  }
+  std::cout << "ok" << std::endl;
+  return 0;
+}
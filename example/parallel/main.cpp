@@ -0,0 +1,113 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Check the parallel algorithms against their sequential results.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "parallel.h"
+#include "thread_pool.h"
+
+namespace {
+
+bool Check(bool ok, const std::string& what) {
+  if (!ok) {
+    std::cerr << "FAILED, " << what << std::endl;
+  }
+  return ok;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  const int kCount = 1 << 20;
+  Utils::ThreadPool pool(4);
+
+  // Every index visited exactly once, with a small grain for many chunks
+  std::vector<std::atomic<int>> visits(kCount);
+  Utils::ParallelFor(pool, 0, kCount, 1024, [&visits](int begin, int end) {
+    for (int i = begin; i < end; i++) {
+      visits[i]++;
+    }
+  });
+  bool once = std::all_of(visits.begin(), visits.end(),
+                          [](const std::atomic<int>& v) { return v == 1; });
+  if (!Check(once, "ParallelFor visited an index twice or never")) {
+    return 1;
+  }
+
+  std::vector<uint64_t> values(kCount);
+  unsigned seed = 1;
+  for (auto &value : values) {
+    seed = seed * 1103515245u + 12345u;
+    value = seed >> 8;
+  }
+  uint64_t expected_sum = 0;
+  for (uint64_t value : values) {
+    expected_sum += value;
+  }
+  uint64_t sum = Utils::ParallelReduce(
+      pool, 0, kCount, 0, static_cast<uint64_t>(0),
+      [&values](int begin, int end) {
+        uint64_t partial = 0;
+        for (int i = begin; i < end; i++) {
+          partial += values[i];
+        }
+        return partial;
+      },
+      [](uint64_t a, uint64_t b) { return a + b; });
+  if (!Check(sum == expected_sum, "ParallelReduce computed a wrong sum")) {
+    return 1;
+  }
+
+  std::vector<uint64_t> doubled(kCount);
+  Utils::ParallelTransform(pool, values.begin(), values.end(),
+                           doubled.begin(), 0,
+                           [](uint64_t v) { return v * 2; });
+  for (int i = 0; i < kCount; i++) {
+    if (!Check(doubled[i] == values[i] * 2, "ParallelTransform mismatch")) {
+      return 1;
+    }
+  }
+
+  std::vector<uint64_t> sorted = values;
+  std::sort(sorted.begin(), sorted.end());
+  auto start = std::chrono::steady_clock::now();
+  Utils::ParallelSort(pool, values.begin(), values.end(),
+                      std::less<uint64_t>());
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+  std::cout << "sorted " << kCount << " values in " << elapsed.count()
+            << " ms" << std::endl;
+  if (!Check(values == sorted, "ParallelSort result differs")) {
+    return 1;
+  }
+
+  // A throwing chunk is rethrown only after every chunk finished
+  std::atomic<int> finished{0};
+  bool caught = false;
+  try {
+    Utils::ParallelFor(pool, 0, 64, 1, [&finished](int begin, int end) {
+      if (begin == 7) {
+        throw std::runtime_error("expected");
+      }
+      finished += end - begin;
+    });
+  } catch (const std::runtime_error&) {
+    caught = true;
+  }
+  if (!Check(caught && finished == 63, "exception not propagated")) {
+    return 1;
+  }
+  std::cout << "ok" << std::endl;
+  return 0;
+}
@@ -0,0 +1,114 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Exercise ThreadSafePriorityQueue ordering and deadline pops.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "thread_safe_priority_queue.h"
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Job {
+  Clock::time_point due;
+  int id;
+};
+
+// Earliest deadline on top
+struct LaterDue {
+  bool operator()(const Job& a, const Job& b) const { return a.due > b.due; }
+};
+
+bool Check(bool ok, const std::string& what) {
+  if (!ok) {
+    std::cerr << "FAILED, " << what << std::endl;
+  }
+  return ok;
+}
+
+// Concurrent pushes, then pops must come out greatest first.
+bool Ordering() {
+  Utils::ThreadSafePriorityQueue<int> queue;
+  const int kPerProducer = 20000;
+  std::vector<std::thread> producers;
+  for (int p = 0; p < 2; p++) {
+    producers.emplace_back([&queue, p] {
+      // Per thread LCG, std::rand() is not thread safe
+      unsigned seed = p + 1;
+      for (int i = 0; i < kPerProducer; i++) {
+        seed = seed * 1103515245u + 12345u;
+        queue.Push(static_cast<int>((seed >> 8) % 100000));
+      }
+    });
+  }
+  for (auto &thread : producers) {
+    thread.join();
+  }
+
+  int previous = 100000;
+  int count = 0;
+  int value;
+  while (queue.TryPop(value)) {
+    if (!Check(value <= previous, "pops out of order")) {
+      return false;
+    }
+    previous = value;
+    count++;
+  }
+  std::cout << "ordering: " << count << " values popped in order"
+            << std::endl;
+  return Check(count == 2 * kPerProducer, "values lost");
+}
+
+// Each push puts an earlier deadline on top while the consumer is already
+// waiting for a later one, so it has to re-arm. Nothing may be popped
+// before it is due.
+bool Deadlines() {
+  Utils::ThreadSafePriorityQueue<Job, LaterDue> queue;
+  auto due_of = [](const Job& job) { return job.due; };
+  std::vector<int> order;
+  bool early = false;
+  std::thread consumer([&] {
+    Job job;
+    while (queue.WaitAndPopWhenDue(job, due_of)) {
+      early = early || Clock::now() < job.due;
+      order.push_back(job.id);
+    }
+  });
+
+  Clock::time_point start = Clock::now();
+  for (int id = 4; id >= 1; id--) {
+    queue.Push(Job{start + std::chrono::milliseconds(20 * id), id});
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(120));
+  queue.Close();
+  consumer.join();
+
+  std::cout << "deadlines: popped";
+  for (int id : order) {
+    std::cout << " " << id;
+  }
+  std::cout << std::endl;
+  return Check(!early, "a job was popped before it was due") &&
+         Check(order == std::vector<int>({1, 2, 3, 4}),
+               "jobs popped out of deadline order");
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  if (!Ordering() || !Deadlines()) {
+    return 1;
+  }
+  std::cout << "ok" << std::endl;
+  return 0;
+}
@@ -0,0 +1,113 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Consume two ThreadSafeQueues, one of them bounded, through a
+ * QueueSet.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "queue_set.h"
+#include "thread_safe_queue.h"
+
+namespace {
+
+bool Check(bool ok, const std::string& what) {
+  if (!ok) {
+    std::cerr << "FAILED, " << what << std::endl;
+  }
+  return ok;
+}
+
+// One consumer selects over a bounded queue fed with ranges longer than
+// its capacity and an unbounded one fed value by value, until both are
+// closed and drained.
+bool Select() {
+  const int kRanges = 500;
+  const int kSingles = 5000;
+  Utils::ThreadSafeQueue<int, Utils::ValueStorage> bounded(4);
+  Utils::ThreadSafeQueue<int, Utils::ValueStorage> unbounded;
+  Utils::QueueSet set(Utils::SelectPolicy::kRoundRobin);
+  size_t bounded_index = set.Add(bounded);
+  set.Add(unbounded);
+
+  size_t index;
+  if (!Check(set.SelectFor(index, std::chrono::milliseconds(10)) ==
+                 Utils::QueueStatus::kTimeout,
+             "select on empty members did not time out")) {
+    return false;
+  }
+
+  std::thread range_producer([&bounded] {
+    std::vector<int> range(10, 1);
+    for (int r = 0; r < kRanges; r++) {
+      bounded.PushRange(range.begin(), range.end());
+    }
+    bounded.Close();
+  });
+  std::thread producer([&unbounded] {
+    for (int i = 0; i < kSingles; i++) {
+      unbounded.Push(i);
+    }
+    unbounded.Close();
+  });
+
+  int from_bounded = 0;
+  int from_unbounded = 0;
+  int value;
+  while (set.Select(index)) {
+    if (index == bounded_index) {
+      from_bounded += bounded.TryPop(value) ? 1 : 0;
+    } else {
+      from_unbounded += unbounded.TryPop(value) ? 1 : 0;
+    }
+  }
+  range_producer.join();
+  producer.join();
+  std::cout << "select: " << from_bounded << " bounded, " << from_unbounded
+            << " unbounded" << std::endl;
+  return Check(from_bounded == kRanges * 10 && from_unbounded == kSingles,
+               "select lost values");
+}
+
+// Sets come and go over a queue that is pushed to all the time, so their
+// destruction races with notifications in flight. A use after free shows
+// up as a crash or under a sanitizer.
+void Churn() {
+  Utils::ThreadSafeQueue<int> queue;
+  std::atomic<bool> running{true};
+  std::thread producer([&queue, &running] {
+    while (running) {
+      queue.Push(1);
+      std::vector<int> drained;
+      queue.PopAll(drained);
+    }
+  });
+  for (int i = 0; i < 2000; i++) {
+    std::unique_ptr<Utils::QueueSet> set(new Utils::QueueSet());
+    set->Add(queue);
+    size_t index;
+    set->TrySelect(index);
+  }
+  running = false;
+  producer.join();
+  std::cout << "churn: 2000 sets destroyed during pushes" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  if (!Select()) {
+    return 1;
+  }
+  Churn();
+  std::cout << "ok" << std::endl;
+  return 0;
+}
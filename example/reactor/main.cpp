@@ -0,0 +1,114 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief An epoll loop serving an unbounded and a bounded EventFdQueue next
+ * to a timer.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "event_fd_queue.h"
+
+int main(int argc, char *argv[]) {
+  Utils::EventFdQueue<std::string> queue;
+  // Producers push ranges longer than the capacity, so they block halfway
+  // through a batch and the loop must still be woken for what went in
+  Utils::EventFdQueue<int> bounded(4);
+  if (queue.GetFd() < 0 || bounded.GetFd() < 0) {
+    std::cerr << "eventfd failed" << std::endl;
+    return 1;
+  }
+
+  int timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  itimerspec interval = {};
+  interval.it_interval.tv_nsec = 100 * 1000 * 1000;
+  interval.it_value.tv_nsec = 100 * 1000 * 1000;
+  timerfd_settime(timer_fd, 0, &interval, nullptr);
+
+  int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  epoll_event event = {};
+  event.events = EPOLLIN;
+  event.data.fd = queue.GetFd();
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, queue.GetFd(), &event);
+  event.data.fd = bounded.GetFd();
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, bounded.GetFd(), &event);
+  event.data.fd = timer_fd;
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, timer_fd, &event);
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < 2; p++) {
+    producers.emplace_back([&queue, p] {
+      for (int i = 0; i < 1000; i++) {
+        queue.Push("producer " + std::to_string(p) + " message " +
+                   std::to_string(i));
+        if (i % 100 == 0) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+      }
+    });
+  }
+  const int kRanges = 500;
+  std::thread range_producer([&bounded] {
+    std::vector<int> range(10, 1);
+    for (int r = 0; r < kRanges; r++) {
+      bounded.PushRange(range.begin(), range.end());
+    }
+    bounded.Close();
+  });
+  std::thread closer([&producers, &queue] {
+    for (auto &producer : producers) {
+      producer.join();
+    }
+    queue.Close();
+  });
+
+  size_t received = 0;
+  size_t received_bounded = 0;
+  std::vector<std::string> batch;
+  std::vector<int> bounded_batch;
+  epoll_event events[8];
+  // Close() fires the fd once more, which may come after the last Drain
+  bool queue_open = true;
+  bool bounded_open = true;
+  while (queue_open || bounded_open) {
+    int ready = epoll_wait(epoll_fd, events, 8, -1);
+    for (int i = 0; i < ready; i++) {
+      if (events[i].data.fd == timer_fd) {
+        uint64_t expirations = 0;
+        read(timer_fd, &expirations, sizeof(expirations));
+        std::cout << "tick, received " << received << " and "
+                  << received_bounded << std::endl;
+      } else if (events[i].data.fd == bounded.GetFd()) {
+        bounded_batch.clear();
+        received_bounded += bounded.Drain(bounded_batch);
+        bounded_open = !bounded.IsClosed() || !bounded.IsEmpty();
+      } else {
+        batch.clear();
+        // Bounded batches keep the timer responsive, Drain re-arms the fd
+        received += queue.Drain(batch, 256);
+        queue_open = !queue.IsClosed() || !queue.IsEmpty();
+      }
+    }
+  }
+  closer.join();
+  range_producer.join();
+  std::cout << "done, received " << received << " and " << received_bounded
+            << std::endl;
+
+  close(epoll_fd);
+  close(timer_fd);
+  if (received != 2000 || received_bounded != kRanges * 10u) {
+    std::cerr << "FAILED, messages lost" << std::endl;
+    return 1;
+  }
+  return 0;
+}
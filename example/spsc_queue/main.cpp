@@ -0,0 +1,91 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Stream a sequence through SpscQueue, spinning and blocking.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+
+#include "spsc_queue.h"
+
+namespace {
+
+const uint64_t kCount = 500000;
+
+// Push 0..kCount-1 in order, mixing single and bulk pushes, and pause now
+// and then so a blocking consumer parks. Returns false on a gap or
+// reordering seen by the consumer.
+bool Stream(bool blocking) {
+  Utils::SpscQueue<uint64_t> queue(64, blocking);
+  std::thread producer([&queue] {
+    uint64_t next = 0;
+    uint64_t next_pause = 0;
+    uint64_t batch[16];
+    while (next < kCount) {
+      if (next >= next_pause) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        next_pause += 50000;
+      }
+      if ((next / 1000) % 2 == 0) {
+        queue.Push(next++);
+        continue;
+      }
+      size_t count = 0;
+      while (count < 16 && next + count < kCount) {
+        batch[count] = next + count;
+        count++;
+      }
+      size_t pushed = queue.TryPushBulk(batch, count);
+      if (pushed == 0) {
+        std::this_thread::yield();
+      }
+      next += pushed;
+    }
+  });
+
+  bool in_order = true;
+  uint64_t expected = 0;
+  uint64_t batch[16];
+  while (expected < kCount) {
+    if ((expected / 777) % 2 == 0) {
+      uint64_t value;
+      queue.WaitAndPop(value);
+      in_order = in_order && value == expected;
+      expected++;
+      continue;
+    }
+    size_t count = queue.TryPopBulk(batch, 16);
+    if (count == 0) {
+      std::this_thread::yield();
+    }
+    for (size_t i = 0; i < count; i++) {
+      in_order = in_order && batch[i] == expected;
+      expected++;
+    }
+  }
+  producer.join();
+  return in_order && queue.IsEmpty();
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  for (bool blocking : {false, true}) {
+    auto start = std::chrono::steady_clock::now();
+    bool ok = Stream(blocking);
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    std::cout << (blocking ? "blocking" : "spinning") << ": " << kCount
+              << " values in " << elapsed.count() << " ms" << std::endl;
+    if (!ok) {
+      std::cerr << "FAILED, values lost or reordered" << std::endl;
+      return 1;
+    }
+  }
+  std::cout << "ok" << std::endl;
+  return 0;
+}
@@ -0,0 +1,88 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Exercise ThreadPool: futures, batches, fork-join and shutdown.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "thread_pool.h"
+
+namespace {
+
+bool Check(bool ok, const std::string& what) {
+  if (!ok) {
+    std::cerr << "FAILED, " << what << std::endl;
+  }
+  return ok;
+}
+
+// Naive recursion, every level forks one half onto the pool and waits for
+// it with Await, which runs queued children instead of blocking a worker
+long Fib(Utils::ThreadPool& pool, int n) {
+  if (n < 12) {
+    return n < 2 ? n : Fib(pool, n - 1) + Fib(pool, n - 2);
+  }
+  std::future<long> left = pool.Submit(Fib, std::ref(pool), n - 1);
+  long right = Fib(pool, n - 2);
+  pool.Await(left);
+  return left.get() + right;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  Utils::ThreadPool pool(4);
+
+  std::future<int> sum = pool.Submit([](int a, int b) { return a + b; }, 2, 3);
+  std::future<void> thrown =
+      pool.Submit([] { throw std::runtime_error("expected"); });
+  bool caught = false;
+  try {
+    thrown.get();
+  } catch (const std::runtime_error&) {
+    caught = true;
+  }
+  if (!Check(sum.get() == 5 && caught, "futures lost a result or exception")) {
+    return 1;
+  }
+
+  std::atomic<int> counter{0};
+  std::vector<Utils::ThreadPool::Task> batch(1000, [&counter] { counter++; });
+  pool.PostBatch(batch.begin(), batch.end());
+
+  std::future<long> fib = pool.Submit(Fib, std::ref(pool), 24);
+  long result = fib.get();
+  std::cout << "fib(24) = " << result << std::endl;
+  if (!Check(result == 46368, "fork-join computed a wrong result")) {
+    return 1;
+  }
+
+  // Tasks still queued at Shutdown(), and the children they post, all run
+  std::atomic<int> children{0};
+  for (int i = 0; i < 100; i++) {
+    pool.Post([&pool, &children] {
+      for (int j = 0; j < 10; j++) {
+        pool.Post([&children] { children++; });
+      }
+    });
+  }
+  pool.Shutdown();
+  std::cout << "batch " << counter << ", children " << children
+            << std::endl;
+  if (!Check(counter == 1000 && children == 1000,
+             "shutdown dropped queued tasks") ||
+      !Check(!pool.Post([] {}) && !pool.Submit([] {}).valid(),
+             "pool accepted a task after shutdown")) {
+    return 1;
+  }
+  std::cout << "ok" << std::endl;
+  return 0;
+}
@@ -0,0 +1,213 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Exercise ThreadSafeList from both ends with several threads.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "thread_safe_list.h"
+
+namespace {
+
+const int kProducers = 3;
+const int kPerProducer = 20000;
+
+bool Check(bool ok, const std::string& what) {
+  if (!ok) {
+    std::cerr << "FAILED, " << what << std::endl;
+  }
+  return ok;
+}
+
+// Range pushes at both ends must keep the order of the range.
+bool RangeOrder() {
+  Utils::ThreadSafeList<int> list;
+  std::vector<int> back = {4, 5, 6};
+  std::vector<int> front = {1, 2, 3};
+  list.PushBackRange(back.begin(), back.end());
+  list.PushFrontRange(front.begin(), front.end());
+
+  std::vector<int> out;
+  list.PopAll(out);
+  std::vector<int> expected = {1, 2, 3, 4, 5, 6};
+  return Check(out == expected, "range pushes reordered");
+}
+
+// Producers push batches at either end; consumers take batches from the
+// front, from the back, or everything at once.
+template <typename Storage>
+bool Batches(const std::string& name) {
+  Utils::ThreadSafeList<uint64_t, Storage> list;
+  std::atomic<uint64_t> sum{0};
+  std::atomic<int> popped{0};
+  const int total = kProducers * kPerProducer;
+
+  std::vector<std::thread> threads;
+  for (int p = 0; p < kProducers; p++) {
+    threads.emplace_back([&list, p] {
+      std::vector<uint64_t> batch;
+      for (int i = 1; i <= kPerProducer; i++) {
+        batch.push_back(i);
+        if (batch.size() < 10 && i != kPerProducer) {
+          continue;
+        }
+        if (p % 2 == 0) {
+          list.PushBackRange(batch.begin(), batch.end());
+        } else {
+          list.PushFrontRange(batch.begin(), batch.end());
+        }
+        batch.clear();
+      }
+    });
+  }
+  for (int c = 0; c < 3; c++) {
+    threads.emplace_back([&, c] {
+      std::vector<uint64_t> out;
+      while (popped.load() < total) {
+        size_t count;
+        if (c == 0) {
+          count = list.PopFrontUpTo(out, 16);
+        } else if (c == 1) {
+          count = list.PopBackUpTo(out, 16);
+        } else {
+          count = list.PopAll(out);
+        }
+        if (count == 0) {
+          std::this_thread::yield();
+          continue;
+        }
+        for (uint64_t value : out) {
+          sum += value;
+        }
+        popped += static_cast<int>(count);
+        out.clear();
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  uint64_t expected = static_cast<uint64_t>(kProducers) * kPerProducer *
+                      (kPerProducer + 1) / 2;
+  std::cout << name << " batches: sum " << sum << std::endl;
+  return Check(sum == expected && popped == total && list.IsEmptyExact(),
+               name + " batches lost or duplicated values");
+}
+
+// A timed pop on an empty list times out; Close() wakes blocked consumers
+// only once they drained what was pushed before it, and rejects later
+// pushes.
+bool TimedWaitsAndClose() {
+  Utils::ThreadSafeList<int> list;
+  int value = 0;
+  auto start = std::chrono::steady_clock::now();
+  Utils::QueueStatus status =
+      list.WaitAndPopFrontFor(value, std::chrono::milliseconds(20));
+  auto waited = std::chrono::steady_clock::now() - start;
+  if (!Check(status == Utils::QueueStatus::kTimeout &&
+                 waited >= std::chrono::milliseconds(20),
+             "timed pop on an empty list did not time out")) {
+    return false;
+  }
+
+  const int kValues = 1000;
+  std::atomic<int> popped{0};
+  std::vector<std::thread> consumers;
+  for (int c = 0; c < 3; c++) {
+    consumers.emplace_back([&] {
+      int item;
+      while (list.WaitAndPopFront(item)) {
+        popped++;
+      }
+    });
+  }
+  for (int i = 0; i < kValues; i++) {
+    list.PushBack(i);
+  }
+  list.Close();
+  for (auto &thread : consumers) {
+    thread.join();
+  }
+
+  status = list.WaitAndPopFrontFor(value, std::chrono::milliseconds(20));
+  std::cout << "close: " << popped << " popped before closed" << std::endl;
+  return Check(popped == kValues, "close lost queued values") &&
+         Check(!list.PushBack(1), "push after close accepted") &&
+         Check(status == Utils::QueueStatus::kClosed,
+               "timed pop after close did not report closed");
+}
+
+// Random pushes and pops at both ends of a ValueStorage list, mirrored on
+// a std::deque, so the chunked store wraps and crosses chunk boundaries in
+// both directions with owning elements.
+bool AgainstDeque() {
+  Utils::ThreadSafeList<std::string, Utils::ValueStorage> list;
+  std::deque<std::string> model;
+  unsigned seed = 1;
+  for (int i = 0; i < 200000; i++) {
+    seed = seed * 1103515245u + 12345u;
+    unsigned op = (seed >> 8) % 6;
+    std::string value = std::to_string(i) + std::string(16, '-');
+    std::string popped;
+    switch (op) {
+      case 0:
+      case 1:
+        list.PushBack(value);
+        model.push_back(value);
+        break;
+      case 2:
+        list.PushFront(value);
+        model.push_front(value);
+        break;
+      case 3:
+      case 4:
+        if (list.TryPopFront(popped) != !model.empty() ||
+            (!model.empty() && popped != model.front())) {
+          return Check(false, "front pop differs from std::deque");
+        }
+        if (!model.empty()) {
+          model.pop_front();
+        }
+        break;
+      default:
+        if (list.TryPopBack(popped) != !model.empty() ||
+            (!model.empty() && popped != model.back())) {
+          return Check(false, "back pop differs from std::deque");
+        }
+        if (!model.empty()) {
+          model.pop_back();
+        }
+        break;
+    }
+  }
+  std::vector<std::string> rest;
+  list.PopAll(rest);
+  std::cout << "against deque: " << rest.size() << " left" << std::endl;
+  return Check(rest.size() == model.size() &&
+                   std::equal(rest.begin(), rest.end(), model.begin()),
+               "remaining elements differ from std::deque");
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  if (!RangeOrder() ||
+      !Batches<Utils::SharedPtrStorage>("shared_ptr storage") ||
+      !Batches<Utils::ValueStorage>("value storage") ||
+      !TimedWaitsAndClose() || !AgainstDeque()) {
+    return 1;
+  }
+  std::cout << "ok" << std::endl;
+  return 0;
+}
@@ -0,0 +1,413 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Exercise ThreadSafeQueue with several producers and consumers.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "thread_safe_queue.h"
+
+namespace {
+
+const int kProducers = 3;
+const int kConsumers = 2;
+const int kPerProducer = 20000;
+
+bool Check(bool ok, const std::string& what) {
+  if (!ok) {
+    std::cerr << "FAILED, " << what << std::endl;
+  }
+  return ok;
+}
+
+// Push owning strings by rvalue and pop them into a T&, half of the
+// consumers through the shared_ptr returning call. Every value must come
+// out exactly once.
+template <typename Storage>
+bool Transfer(const std::string& name) {
+  Utils::ThreadSafeQueue<std::string, Storage> queue;
+  std::atomic<uint64_t> sum{0};
+  std::atomic<int> popped{0};
+  const int total = kProducers * kPerProducer;
+
+  std::vector<std::thread> threads;
+  for (int p = 0; p < kProducers; p++) {
+    threads.emplace_back([&queue] {
+      for (int i = 1; i <= kPerProducer; i++) {
+        std::string value = std::to_string(i);
+        queue.Push(std::move(value));
+      }
+    });
+  }
+  for (int c = 0; c < kConsumers; c++) {
+    threads.emplace_back([&, c] {
+      while (popped.fetch_add(1) < total) {
+        if (c == 0) {
+          std::string value;
+          queue.WaitAndPop(value);
+          sum += std::stoull(value);
+        } else {
+          std::shared_ptr<std::string> value = queue.WaitAndPop();
+          sum += std::stoull(*value);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  uint64_t expected = static_cast<uint64_t>(kProducers) * kPerProducer *
+                      (kPerProducer + 1) / 2;
+  std::cout << name << ": sum " << sum << std::endl;
+  return Check(sum == expected && queue.IsEmptyExact(),
+               name + " lost or duplicated values");
+}
+
+// Producers push batches with PushRange; one consumer drains with PopAll,
+// the others take bounded batches with PopUpTo and WaitAndPopUpTo.
+bool Batches() {
+  Utils::ThreadSafeQueue<uint64_t, Utils::ValueStorage> queue;
+  std::atomic<uint64_t> sum{0};
+  std::atomic<int> popped{0};
+  const int total = kProducers * kPerProducer;
+
+  std::vector<std::thread> threads;
+  for (int p = 0; p < kProducers; p++) {
+    threads.emplace_back([&queue] {
+      std::vector<uint64_t> batch;
+      for (int i = 1; i <= kPerProducer; i++) {
+        batch.push_back(i);
+        if (batch.size() == 10 || i == kPerProducer) {
+          queue.PushRange(batch.begin(), batch.end());
+          batch.clear();
+        }
+      }
+    });
+  }
+  for (int c = 0; c < kConsumers + 1; c++) {
+    threads.emplace_back([&, c] {
+      std::vector<uint64_t> out;
+      while (popped.load() < total) {
+        size_t count;
+        if (c == 0) {
+          count = queue.PopAll(out);
+        } else if (c == 1) {
+          count = queue.PopUpTo(out, 16);
+        } else {
+          count = queue.WaitAndPopUpTo(out, 16,
+                                       std::chrono::milliseconds(10));
+        }
+        if (count == 0) {
+          std::this_thread::yield();
+          continue;
+        }
+        for (uint64_t value : out) {
+          sum += value;
+        }
+        popped += static_cast<int>(count);
+        out.clear();
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  uint64_t expected = static_cast<uint64_t>(kProducers) * kPerProducer *
+                      (kPerProducer + 1) / 2;
+  std::cout << "batches: sum " << sum << std::endl;
+  return Check(sum == expected && popped == total && queue.IsEmptyExact(),
+               "batches lost or duplicated values");
+}
+
+// A timed pop on an empty queue times out; Close() wakes blocked consumers
+// only once they drained what was pushed before it, and rejects later
+// pushes.
+bool TimedWaitsAndClose() {
+  Utils::ThreadSafeQueue<int> queue;
+  int value = 0;
+  auto start = std::chrono::steady_clock::now();
+  Utils::QueueStatus status =
+      queue.WaitAndPopFor(value, std::chrono::milliseconds(20));
+  auto waited = std::chrono::steady_clock::now() - start;
+  if (!Check(status == Utils::QueueStatus::kTimeout &&
+                 waited >= std::chrono::milliseconds(20),
+             "timed pop on an empty queue did not time out")) {
+    return false;
+  }
+
+  const int kValues = 1000;
+  std::atomic<int> popped{0};
+  std::vector<std::thread> consumers;
+  for (int c = 0; c < 3; c++) {
+    consumers.emplace_back([&] {
+      int item;
+      while (queue.WaitAndPop(item)) {
+        popped++;
+      }
+    });
+  }
+  for (int i = 0; i < kValues; i++) {
+    queue.Push(i);
+  }
+  queue.Close();
+  for (auto &thread : consumers) {
+    thread.join();
+  }
+
+  status = queue.WaitAndPopFor(value, std::chrono::milliseconds(20));
+  std::cout << "close: " << popped << " popped before closed" << std::endl;
+  return Check(popped == kValues, "close lost queued values") &&
+         Check(!queue.Push(1), "push after close accepted") &&
+         Check(status == Utils::QueueStatus::kClosed,
+               "timed pop after close did not report closed");
+}
+
+// A blocking producer pushes ranges longer than the capacity; the other
+// policies are checked single threaded on what they keep and count.
+bool Bounded() {
+  Utils::ThreadSafeQueue<uint64_t, Utils::ValueStorage> blocking(4);
+  const int kRanges = 2000;
+  std::thread producer([&blocking] {
+    std::vector<uint64_t> range;
+    for (int r = 0; r < kRanges; r++) {
+      range.assign(10, static_cast<uint64_t>(r));
+      blocking.PushRange(range.begin(), range.end());
+    }
+  });
+  uint64_t sum = 0;
+  uint64_t value;
+  for (int i = 0; i < kRanges * 10; i++) {
+    blocking.WaitAndPop(value);
+    sum += value;
+  }
+  producer.join();
+  std::cout << "bounded: producers blocked for "
+            << std::chrono::duration_cast<std::chrono::microseconds>(
+                   blocking.GetProducerBlockTime()).count()
+            << " us" << std::endl;
+  if (!Check(sum == 10ull * kRanges * (kRanges - 1) / 2,
+             "bounded PushRange lost values")) {
+    return false;
+  }
+  for (int i = 0; i < 4; i++) {
+    blocking.Push(i);
+  }
+  if (!Check(!blocking.PushFor(4, std::chrono::milliseconds(5)) &&
+                 blocking.GetRejectedCount() == 1,
+             "PushFor on a full queue did not time out")) {
+    return false;
+  }
+
+  struct Expectation {
+    Utils::OverflowPolicy policy;
+    int accepted;
+    std::vector<int> kept;
+    uint64_t dropped;
+    uint64_t rejected;
+  };
+  const Expectation expectations[] = {
+      {Utils::OverflowPolicy::kReject, 4, {1, 2, 3, 4}, 0, 2},
+      {Utils::OverflowPolicy::kDropOldest, 6, {3, 4, 5, 6}, 2, 0},
+      {Utils::OverflowPolicy::kDropNewest, 4, {1, 2, 3, 4}, 2, 0}};
+  for (const Expectation& expect : expectations) {
+    Utils::ThreadSafeQueue<int> queue(4, expect.policy);
+    int accepted = 0;
+    for (int i = 1; i <= 6; i++) {
+      accepted += queue.Push(i) ? 1 : 0;
+    }
+    std::vector<int> kept;
+    queue.PopAll(kept);
+    if (!Check(accepted == expect.accepted && kept == expect.kept &&
+                   queue.GetDroppedCount() == expect.dropped &&
+                   queue.GetRejectedCount() == expect.rejected,
+               "overflow policy " +
+                   std::to_string(static_cast<int>(expect.policy)) +
+                   " kept the wrong values")) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// A consumer under each wait strategy against a producer whose ranges
+// overflow a small bounded queue, so the producer blocks halfway through a
+// batch with the consumer still spinning on the size hint.
+bool WaitStrategies() {
+  const Utils::WaitStrategy strategies[] = {
+      Utils::WaitStrategy::kBlocking, Utils::WaitStrategy::kSpinThenPark,
+      Utils::WaitStrategy::kBusySpin};
+  const int kRanges = 50;
+  for (Utils::WaitStrategy strategy : strategies) {
+    Utils::ThreadSafeQueue<uint64_t, Utils::ValueStorage> queue(4);
+    queue.SetWaitStrategy(strategy);
+    uint64_t sum = 0;
+    std::thread consumer([&queue, &sum] {
+      uint64_t value;
+      while (queue.WaitAndPop(value)) {
+        sum += value;
+      }
+    });
+    auto start = std::chrono::steady_clock::now();
+    std::vector<uint64_t> range;
+    for (int r = 0; r < kRanges; r++) {
+      range.assign(10, static_cast<uint64_t>(r));
+      queue.PushRange(range.begin(), range.end());
+    }
+    queue.Close();
+    consumer.join();
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    std::cout << "wait strategy " << static_cast<int>(strategy) << ": "
+              << elapsed.count() << " us" << std::endl;
+    if (!Check(sum == 10ull * kRanges * (kRanges - 1) / 2,
+               "a spinning consumer lost values")) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Pushes skip the notify while no consumer sleeps, so a lost wake-up
+// leaves values queued behind parked consumers. Blocking consumers park
+// between bursts of single and range pushes; for the first half, timed
+// waiters that keep timing out churn the waiter count alongside them.
+bool ManyWaiters() {
+  Utils::ThreadSafeQueue<int, Utils::ValueStorage> queue;
+  const int kWaiters = 6;
+  const int kBursts = 200;
+  std::atomic<int> popped{0};
+  std::atomic<bool> churn{true};
+  std::vector<std::thread> consumers;
+  for (int c = 0; c < kWaiters; c++) {
+    consumers.emplace_back([&queue, &popped] {
+      int value;
+      while (queue.WaitAndPop(value)) {
+        popped++;
+      }
+    });
+  }
+  for (int c = 0; c < 3; c++) {
+    consumers.emplace_back([&queue, &popped, &churn] {
+      int value;
+      while (churn) {
+        if (queue.WaitAndPopFor(value, std::chrono::milliseconds(1)) ==
+            Utils::QueueStatus::kSuccess) {
+          popped++;
+        }
+      }
+    });
+  }
+
+  std::vector<int> range(3, 1);
+  for (int b = 0; b < kBursts; b++) {
+    if (b == kBursts / 2) {
+      churn = false;
+    }
+    queue.Push(b);
+    queue.PushRange(range.begin(), range.end());
+    // Let the consumers drain the burst and park again, give up if a
+    // parked one is never woken
+    auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (popped < (b + 1) * 4 &&
+           std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::yield();
+    }
+    if (popped < (b + 1) * 4) {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+  }
+  int popped_before_close = popped;
+  churn = false;
+  queue.Close();
+  for (auto &thread : consumers) {
+    thread.join();
+  }
+  std::cout << "many waiters: " << popped_before_close << " popped"
+            << std::endl;
+  return Check(popped_before_close == kBursts * 4,
+               "a parked consumer missed a wake-up");
+}
+
+// The lock-free Size() and IsEmpty() must match the exact values once the
+// pushing thread stops, including while it is blocked inside a PushRange.
+bool SizeHint() {
+  Utils::ThreadSafeQueue<int, Utils::ValueStorage> queue(4);
+  std::vector<int> range(10, 1);
+  std::thread producer([&queue, &range] {
+    queue.PushRange(range.begin(), range.end());
+  });
+  while (queue.SizeExact() < 4) {
+    std::this_thread::yield();
+  }
+  // Give the producer time to block on the full queue
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  bool blocked_ok = queue.Size() == 4 && !queue.IsEmpty();
+
+  std::vector<int> out;
+  while (out.size() < range.size()) {
+    queue.WaitAndPopUpTo(out, 3, std::chrono::milliseconds(10));
+  }
+  producer.join();
+  bool drained_ok = queue.Size() == 0 && queue.IsEmpty();
+  std::cout << "size hint: " << (blocked_ok && drained_ok ? "exact" : "stale")
+            << std::endl;
+  return Check(blocked_ok, "hint stale while a producer was blocked") &&
+         Check(drained_ok, "hint stale after draining");
+}
+
+// With QueueTelemetry every element pushed is either popped or discarded
+// by the overflow policy; print the snapshot as JSON.
+bool Telemetry() {
+  Utils::ThreadSafeQueue<int, Utils::ValueStorage, Utils::QueueTelemetry>
+      queue(64, Utils::OverflowPolicy::kDropOldest);
+  const int kValues = 20000;
+  std::thread consumer([&queue] {
+    int value;
+    while (queue.WaitAndPop(value)) {
+    }
+  });
+  for (int i = 0; i < kValues; i++) {
+    queue.Push(i);
+  }
+  queue.Close();
+  consumer.join();
+
+  Utils::QueueTelemetrySnapshot snapshot = queue.GetTelemetry();
+  std::cout << "telemetry: " << Utils::TelemetryToJson(snapshot, -1)
+            << std::endl;
+  Utils::ThreadSafeQueue<int> plain;
+  return Check(snapshot.enabled && snapshot.enqueued == kValues &&
+                   snapshot.dequeued + snapshot.discarded == kValues &&
+                   snapshot.discarded == queue.GetDroppedCount() &&
+                   snapshot.depth == 0 && snapshot.max_depth <= 64,
+               "telemetry counters do not add up") &&
+         Check(!plain.GetTelemetry().enabled,
+               "telemetry enabled without QueueTelemetry");
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  bool ok = Transfer<Utils::SharedPtrStorage>("shared_ptr storage") &&
+            Transfer<Utils::ValueStorage>("value storage") && Batches() &&
+            TimedWaitsAndClose() && Bounded() && WaitStrategies() &&
+            ManyWaiters() && SizeHint() && Telemetry();
+  if (!ok) {
+    return 1;
+  }
+  std::cout << "ok" << std::endl;
+  return 0;
+}
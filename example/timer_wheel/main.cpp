@@ -0,0 +1,120 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Fire many timers across the wheel levels, simulated and live.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "timer_wheel.h"
+#include "timestamp.h"
+
+namespace {
+
+bool Check(bool ok, const std::string& what) {
+  if (!ok) {
+    std::cerr << "FAILED, " << what << std::endl;
+  }
+  return ok;
+}
+
+// Drive a wheel on simulated time in uneven steps. Delays up to about an
+// hour cross three levels; a third of the timers is cancelled. Every other
+// timer must fire on the first Advance() at or after its expiry.
+bool Simulated() {
+  const int kTimers = 100000;
+  const Utils::TimeStamp kHorizon = 1 << 22;
+  Utils::TimerWheel wheel(1, 0);
+  wheel.Reserve(kTimers);
+
+  Utils::TimeStamp previous = 0;
+  Utils::TimeStamp now = 0;
+  int fired = 0;
+  int mistimed = 0;
+  std::vector<Utils::TimerWheel::TimerId> ids;
+  unsigned seed = 1;
+  for (int i = 0; i < kTimers; i++) {
+    seed = seed * 1103515245u + 12345u;
+    // Mostly short timeouts, some long ones
+    Utils::TimeStamp delay = (seed >> 8) % (i % 10 == 0 ? kHorizon : 1000);
+    ids.push_back(wheel.ScheduleAt(delay, [&, delay] {
+      fired++;
+      mistimed += (delay > now || delay <= previous) && delay != 0 ? 1 : 0;
+    }));
+  }
+  int cancelled = 0;
+  for (int i = 0; i < kTimers; i += 3) {
+    cancelled += wheel.Cancel(ids[i]) ? 1 : 0;
+  }
+
+  while (!wheel.IsEmpty()) {
+    seed = seed * 1103515245u + 12345u;
+    previous = now;
+    now += 1 + (seed >> 8) % 5000;
+    wheel.Advance(now);
+  }
+  std::cout << "simulated: " << fired << " fired, " << cancelled
+            << " cancelled" << std::endl;
+  return Check(fired == kTimers - cancelled, "timers lost") &&
+         Check(mistimed == 0, "timers fired early or late");
+}
+
+// Several threads schedule and cancel short timers while Run() drives the
+// wheel from the clock.
+bool Live() {
+  Utils::ThreadSafeTimerWheel wheel(1);
+  std::thread driver([&wheel] { wheel.Run(); });
+
+  std::atomic<int> fired{0};
+  std::atomic<int> early{0};
+  std::atomic<int> cancelled{0};
+  const int kPerThread = 2000;
+  std::vector<std::thread> schedulers;
+  for (int t = 0; t < 3; t++) {
+    schedulers.emplace_back([&, t] {
+      for (int i = 0; i < kPerThread; i++) {
+        Utils::TimeStamp delay = 1 + (i * 7 + t) % 50;
+        Utils::TimeStamp due = Utils::GetTimeStamp() + delay;
+        Utils::ThreadSafeTimerWheel::TimerId id =
+            wheel.Schedule(delay, [&fired, &early, due] {
+              early += Utils::GetTimeStamp() < due ? 1 : 0;
+              fired++;
+            });
+        if (i % 2 == 0 && wheel.Cancel(id)) {
+          cancelled++;
+        }
+      }
+    });
+  }
+  for (auto &thread : schedulers) {
+    thread.join();
+  }
+  Utils::TimeStamp deadline = Utils::GetTimeStamp() + 2000;
+  while (wheel.Size() > 0 && Utils::GetTimeStamp() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  wheel.Stop();
+  driver.join();
+
+  std::cout << "live: " << fired << " fired, " << cancelled << " cancelled"
+            << std::endl;
+  return Check(fired + cancelled == 3 * kPerThread, "timers lost") &&
+         Check(early == 0, "timers fired early");
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  if (!Simulated() || !Live()) {
+    return 1;
+  }
+  std::cout << "ok" << std::endl;
+  return 0;
+}
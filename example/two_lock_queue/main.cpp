@@ -0,0 +1,85 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Stress TwoLockQueue and its node recycling.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "two_lock_queue.h"
+
+int main(int argc, char *argv[]) {
+  const int kProducers = 3;
+  const int kConsumers = 3;
+  const int kPerProducer = 30000;
+
+  // Owning strings make a node recycled without destroying its element, or
+  // destroyed twice, show up under a sanitizer
+  Utils::TwoLockQueue<std::string> queue(64);
+  std::atomic<uint64_t> sum{0};
+  std::atomic<int> popped{0};
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; p++) {
+    producers.emplace_back([&queue] {
+      for (int i = 1; i <= kPerProducer; i++) {
+        queue.Push(std::to_string(i) + std::string(20, ' '));
+      }
+    });
+  }
+  std::vector<std::thread> consumers;
+  for (int c = 0; c < kConsumers; c++) {
+    consumers.emplace_back([&, c] {
+      std::string value;
+      while (true) {
+        if (c == 0) {
+          if (!queue.WaitAndPop(value)) {
+            break;
+          }
+        } else if (c == 1) {
+          std::shared_ptr<std::string> res = queue.WaitAndPop();
+          if (!res) {
+            break;
+          }
+          value = std::move(*res);
+        } else {
+          Utils::QueueStatus status =
+              queue.WaitAndPopFor(value, std::chrono::milliseconds(5));
+          if (status == Utils::QueueStatus::kClosed) {
+            break;
+          }
+          if (status == Utils::QueueStatus::kTimeout) {
+            continue;
+          }
+        }
+        sum += std::stoull(value);
+        popped++;
+      }
+    });
+  }
+  for (auto &thread : producers) {
+    thread.join();
+  }
+  queue.Close();
+  for (auto &thread : consumers) {
+    thread.join();
+  }
+
+  uint64_t expected = static_cast<uint64_t>(kProducers) * kPerProducer *
+                      (kPerProducer + 1) / 2;
+  std::cout << "popped " << popped << ", sum " << sum << std::endl;
+  if (sum != expected || !queue.IsEmpty() || queue.Push("late")) {
+    std::cerr << "FAILED, expected sum " << expected << std::endl;
+    return 1;
+  }
+  std::cout << "ok" << std::endl;
+  return 0;
+}
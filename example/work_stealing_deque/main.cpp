@@ -0,0 +1,77 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Stress WorkStealingDeque with one owner and several thieves.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "work_stealing_deque.h"
+
+int main(int argc, char *argv[]) {
+  const int kThieves = 3;
+  const int kValues = 200000;
+
+  // A tiny initial ring makes the owner grow it while thieves steal
+  Utils::WorkStealingDeque<int> deque(4);
+  std::unique_ptr<std::atomic<int>[]> seen(new std::atomic<int>[kValues]);
+  for (int i = 0; i < kValues; i++) {
+    seen[i].store(0);
+  }
+  std::atomic<int> taken{0};
+  std::atomic<int> stolen{0};
+
+  std::vector<std::thread> thieves;
+  for (int t = 0; t < kThieves; t++) {
+    thieves.emplace_back([&] {
+      int value;
+      while (taken.load() < kValues) {
+        if (!deque.TrySteal(value)) {
+          std::this_thread::yield();
+          continue;
+        }
+        seen[value]++;
+        stolen++;
+        taken++;
+      }
+    });
+  }
+
+  // The owner pushes in bursts and pops some back itself, racing the
+  // thieves for the last element
+  int value;
+  for (int i = 0; i < kValues; i++) {
+    deque.Push(i);
+    if (i % 3 == 0 && deque.TryPop(value)) {
+      seen[value]++;
+      taken++;
+    }
+  }
+  while (deque.TryPop(value)) {
+    seen[value]++;
+    taken++;
+  }
+  for (auto &thread : thieves) {
+    thread.join();
+  }
+
+  int duplicated = 0;
+  int lost = 0;
+  for (int i = 0; i < kValues; i++) {
+    duplicated += seen[i] > 1 ? 1 : 0;
+    lost += seen[i] == 0 ? 1 : 0;
+  }
+  std::cout << "stolen " << stolen << " of " << kValues << std::endl;
+  if (duplicated != 0 || lost != 0 || !deque.IsEmpty()) {
+    std::cerr << "FAILED, " << duplicated << " duplicated, " << lost
+              << " lost" << std::endl;
+    return 1;
+  }
+  std::cout << "ok" << std::endl;
+  return 0;
+}
@@ -0,0 +1,191 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Bounded lock-free multi-producer multi-consumer queue.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#ifndef UTILS_BOUNDED_MPMC_QUEUE_H_
+#define UTILS_BOUNDED_MPMC_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "lock_free_common.h"
+
+namespace Utils {
+
+/**
+ * Array based MPMC queue after D. Vyukov. Every cell carries a sequence
+ * number telling producers and consumers whether it is free or filled for
+ * the current lap, so a push or pop is one CAS on the shared index plus one
+ * store on the cell. Elements are stored by value, the capacity is rounded up
+ * to a power of two and fixed at construction.
+ */
+template <typename T>
+class BoundedMpmcQueue {
+ public:
+  explicit BoundedMpmcQueue(size_t capacity);
+
+  ~BoundedMpmcQueue();
+
+  BoundedMpmcQueue(const BoundedMpmcQueue& other) = delete;
+  BoundedMpmcQueue& operator=(const BoundedMpmcQueue& other) = delete;
+
+  bool TryPush(const T& new_value) { return TryEmplace(new_value); }
+
+  bool TryPush(T&& new_value) { return TryEmplace(std::move(new_value)); }
+
+  template <typename... Args>
+  bool TryEmplace(Args&&... args);
+
+  bool TryPop(T& value);
+
+  /**
+   * Spin, then yield, until there is room for the new value.
+   */
+  void Push(const T& new_value);
+
+  void Push(T&& new_value);
+
+  /**
+   * Spin, then yield, until a value is available.
+   */
+  void WaitAndPop(T& value);
+
+  /**
+   * Approximate under concurrent access.
+   */
+  size_t Size() const;
+
+  bool IsEmpty() const { return Size() == 0; }
+
+  size_t Capacity() const { return mask_ + 1; }
+
+ private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+  };
+
+  Cell* const buffer_;
+  const size_t mask_;
+
+  char padding0_[kCacheLineSize];
+  std::atomic<size_t> enqueue_pos_{0};
+  char padding1_[kCacheLineSize - sizeof(std::atomic<size_t>)];
+  std::atomic<size_t> dequeue_pos_{0};
+  char padding2_[kCacheLineSize - sizeof(std::atomic<size_t>)];
+};
+
+template <typename T>
+BoundedMpmcQueue<T>::BoundedMpmcQueue(size_t capacity)
+    : buffer_(new Cell[RoundUpPowerOfTwo(capacity)]),
+      mask_(RoundUpPowerOfTwo(capacity) - 1) {
+  for (size_t i = 0; i <= mask_; i++) {
+    buffer_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+template <typename T>
+BoundedMpmcQueue<T>::~BoundedMpmcQueue() {
+  size_t tail = enqueue_pos_.load(std::memory_order_relaxed);
+  for (size_t pos = dequeue_pos_.load(std::memory_order_relaxed); pos != tail;
+       pos++) {
+    reinterpret_cast<T*>(&buffer_[pos & mask_].storage)->~T();
+  }
+  delete[] buffer_;
+}
+
+template <typename T>
+template <typename... Args>
+inline bool BoundedMpmcQueue<T>::TryEmplace(Args&&... args) {
+  size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+  Cell* cell;
+  while (true) {
+    cell = &buffer_[pos & mask_];
+    size_t seq = cell->sequence.load(std::memory_order_acquire);
+    intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+    if (dif == 0) {
+      if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                             std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (dif < 0) {
+      // The cell still holds the value of the previous lap, queue is full
+      return false;
+    } else {
+      pos = enqueue_pos_.load(std::memory_order_relaxed);
+    }
+  }
+  new (&cell->storage) T(std::forward<Args>(args)...);
+  cell->sequence.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+template <typename T>
+inline bool BoundedMpmcQueue<T>::TryPop(T& value) {
+  size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+  Cell* cell;
+  while (true) {
+    cell = &buffer_[pos & mask_];
+    size_t seq = cell->sequence.load(std::memory_order_acquire);
+    intptr_t dif =
+        static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+    if (dif == 0) {
+      if (dequeue_pos_.compare_exchange_weak(pos, pos + 1,
+                                             std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (dif < 0) {
+      return false;
+    } else {
+      pos = dequeue_pos_.load(std::memory_order_relaxed);
+    }
+  }
+  T* item = reinterpret_cast<T*>(&cell->storage);
+  value = std::move(*item);
+  item->~T();
+  cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+  return true;
+}
+
+template <typename T>
+void BoundedMpmcQueue<T>::Push(const T& new_value) {
+  Backoff backoff;
+  while (!TryEmplace(new_value)) {
+    backoff.Pause();
+  }
+}
+
+template <typename T>
+void BoundedMpmcQueue<T>::Push(T&& new_value) {
+  Backoff backoff;
+  // TryEmplace only moves from 'new_value' once a cell is claimed
+  while (!TryEmplace(std::move(new_value))) {
+    backoff.Pause();
+  }
+}
+
+template <typename T>
+void BoundedMpmcQueue<T>::WaitAndPop(T& value) {
+  Backoff backoff;
+  while (!TryPop(value)) {
+    backoff.Pause();
+  }
+}
+
+template <typename T>
+size_t BoundedMpmcQueue<T>::Size() const {
+  size_t tail = enqueue_pos_.load(std::memory_order_relaxed);
+  size_t head = dequeue_pos_.load(std::memory_order_relaxed);
+  return tail > head ? tail - head : 0;
+}
+
+}  // namespace Utils
+
+#endif  // UTILS_BOUNDED_MPMC_QUEUE_H_
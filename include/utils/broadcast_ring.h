@@ -0,0 +1,469 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Disruptor style ring where every consumer sees every event.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#ifndef UTILS_BROADCAST_RING_H_
+#define UTILS_BROADCAST_RING_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "lock_free_common.h"
+#include "queue_status.h"
+
+namespace Utils {
+
+/**
+ * Who publishes into a BroadcastRing.
+ */
+enum class ProducerMode {
+  // One publishing thread, claiming a slot is a plain increment
+  kSingle = 0,
+  // Any number of publishing threads, claims are a fetch_add and every slot
+  // carries a flag telling consumers it is published
+  kMulti = 1
+};
+
+/**
+ * Broadcast ring buffer after the LMAX Disruptor. Events live in a
+ * preallocated ring and every consumer keeps its own sequence, so N
+ * subscribers see each event without N copies into N queues:
+ *
+ *   BroadcastRing<Event> ring(1024);
+ *   size_t journal = ring.AddConsumer();
+ *   size_t replicate = ring.AddConsumer();
+ *   // Business logic only sees events both stages above have processed
+ *   size_t logic = ring.AddConsumer({journal, replicate});
+ *   ...
+ *   ring.Publish(event);
+ *   ...
+ *   while (ring.Process(logic, [](Event& e) { Handle(e); }) > 0) {}
+ *
+ * A consumer that depends on others reads an event only after all of them
+ * processed it, and may then modify it in place for consumers depending on
+ * it in turn. Producers wait for the slowest consumer no one depends on
+ * before reusing a slot. Consumers read in batches: Process() hands over
+ * everything available with one sequence update.
+ *
+ * Consumers must be added before the first publish, each consumer id is
+ * used by one thread at a time. 'strategy' selects how consumers wait for
+ * the producers; waiting for another consumer always spins and yields, as
+ * stages are expected to keep up. Producers waiting for space spin and
+ * yield as well.
+ */
+template <typename T>
+class BroadcastRing {
+ public:
+  /**
+   * @param capacity rounded up to a power of two
+   */
+  explicit BroadcastRing(size_t capacity,
+                         ProducerMode mode = ProducerMode::kSingle,
+                         WaitStrategy strategy = WaitStrategy::kSpinThenPark);
+
+  BroadcastRing(const BroadcastRing& other) = delete;
+  BroadcastRing& operator=(const BroadcastRing& other) = delete;
+
+  /**
+   * Register a consumer starting at the next published event, gated on the
+   * consumers in 'depends_on'.
+   * @return the consumer id
+   */
+  size_t AddConsumer(const std::vector<size_t>& depends_on =
+                         std::vector<size_t>());
+
+  /**
+   * Wait for a free slot and publish a copy of 'new_value'.
+   * @return false if the ring is closed
+   */
+  bool Publish(const T& new_value);
+
+  bool Publish(T&& new_value);
+
+  /**
+   * Zero copy publishing: fill At(sequence) in place, then Commit(). Every
+   * claimed sequence must be committed.
+   * @return the claimed sequence, -1 if the ring is closed
+   */
+  int64_t Claim();
+
+  T& At(int64_t sequence) { return entries_[sequence & mask_]; }
+
+  void Commit(int64_t sequence);
+
+  /**
+   * Wait until 'consumer' has events, then call 'handler(T&)' on at most
+   * 'max_batch' of them in order and mark them processed.
+   * @return number of events processed, zero once the ring is closed and
+   * the consumer has seen everything
+   */
+  template <typename Handler>
+  size_t Process(size_t consumer, Handler handler,
+                 size_t max_batch = std::numeric_limits<size_t>::max());
+
+  /**
+   * Like Process, but return zero instead of waiting.
+   */
+  template <typename Handler>
+  size_t TryProcess(size_t consumer, Handler handler,
+                    size_t max_batch = std::numeric_limits<size_t>::max());
+
+  /**
+   * Copy the next event for 'consumer'.
+   * @return false once the ring is closed and the consumer has seen
+   * everything
+   */
+  bool WaitAndRead(size_t consumer, T& value);
+
+  bool TryRead(size_t consumer, T& value);
+
+  /**
+   * Wake every waiting consumer; they drain the published events and then
+   * stop. Call it once every producer is done publishing.
+   */
+  void Close();
+
+  bool IsClosed() const { return closed_.load(std::memory_order_acquire); }
+
+  /**
+   * @return the last sequence 'consumer' processed, -1 before the first
+   */
+  int64_t GetSequence(size_t consumer) const {
+    return consumers_[consumer]->sequence.value.load(
+        std::memory_order_acquire);
+  }
+
+  /**
+   * @return the last claimed sequence, -1 before the first
+   */
+  int64_t GetCursor() const {
+    return claim_.value.load(std::memory_order_acquire);
+  }
+
+  size_t Capacity() const { return mask_ + 1; }
+
+  size_t GetConsumerCount() const { return consumers_.size(); }
+
+ private:
+  // Kept on its own cache line, every consumer and producer polls these
+  struct PaddedSequence {
+    char padding0[kCacheLineSize];
+    std::atomic<int64_t> value{-1};
+    char padding1[kCacheLineSize - sizeof(std::atomic<int64_t>)];
+  };
+
+  struct Consumer {
+    PaddedSequence sequence;
+    std::vector<size_t> depends_on;
+  };
+
+  // Highest sequence readable from 'next' on, published and processed by
+  // every dependency
+  int64_t Available(const Consumer& consumer, int64_t next) const;
+
+  // Highest sequence published without gaps from 'next' on
+  int64_t Published(int64_t next) const;
+
+  // Available(), after waiting per strategy if nothing is, below 'next' once
+  // closed and drained
+  int64_t WaitFor(const Consumer& consumer, int64_t next);
+
+  void WaitForSpace(int64_t sequence);
+
+  int64_t MinGatingSequence() const;
+
+  void NotifyConsumers();
+
+  template <typename Handler>
+  size_t Run(Consumer& consumer, int64_t next, int64_t available,
+             Handler& handler, size_t max_batch);
+
+  static const int kSpinRounds = 16;
+
+  std::vector<T> entries_;
+  const int64_t mask_;
+  int shift_{0};
+  const ProducerMode mode_;
+  const WaitStrategy strategy_;
+
+  std::vector<std::unique_ptr<Consumer> > consumers_;
+  // Consumers no other consumer depends on, producers wait for these
+  std::vector<size_t> gating_;
+
+  // Last claimed sequence
+  PaddedSequence claim_;
+  // kSingle only, the last published sequence
+  PaddedSequence cursor_;
+  // Last known MinGatingSequence(), spares producers the scan. Release and
+  // acquire, so a producer trusting another's value also sees the consumer
+  // reads behind it
+  PaddedSequence gate_cache_;
+  // kMulti only, the lap each slot was last published for
+  std::unique_ptr<std::atomic<int64_t>[]> published_;
+
+  std::atomic<bool> closed_{false};
+  std::atomic<int> waiting_consumers_{0};
+  std::mutex wait_mutex_;
+  std::condition_variable wait_cond_;
+};
+
+template <typename T>
+BroadcastRing<T>::BroadcastRing(size_t capacity, ProducerMode mode,
+                                WaitStrategy strategy)
+    : entries_(RoundUpPowerOfTwo(capacity)),
+      mask_(static_cast<int64_t>(RoundUpPowerOfTwo(capacity)) - 1),
+      mode_(mode),
+      strategy_(strategy) {
+  while ((int64_t(1) << shift_) <= mask_) {
+    shift_++;
+  }
+  if (mode_ == ProducerMode::kMulti) {
+    published_.reset(new std::atomic<int64_t>[mask_ + 1]);
+    for (int64_t i = 0; i <= mask_; i++) {
+      published_[i].store(-1, std::memory_order_relaxed);
+    }
+  }
+}
+
+template <typename T>
+size_t BroadcastRing<T>::AddConsumer(const std::vector<size_t>& depends_on) {
+  std::unique_ptr<Consumer> consumer(new Consumer());
+  consumer->depends_on = depends_on;
+  consumer->sequence.value.store(claim_.value.load(std::memory_order_acquire),
+                           std::memory_order_release);
+  for (size_t dependency : depends_on) {
+    gating_.erase(std::remove(gating_.begin(), gating_.end(), dependency),
+                  gating_.end());
+  }
+  consumers_.push_back(std::move(consumer));
+  gating_.push_back(consumers_.size() - 1);
+  return consumers_.size() - 1;
+}
+
+template <typename T>
+bool BroadcastRing<T>::Publish(const T& new_value) {
+  int64_t sequence = Claim();
+  if (sequence < 0) {
+    return false;
+  }
+  At(sequence) = new_value;
+  Commit(sequence);
+  return true;
+}
+
+template <typename T>
+bool BroadcastRing<T>::Publish(T&& new_value) {
+  int64_t sequence = Claim();
+  if (sequence < 0) {
+    return false;
+  }
+  At(sequence) = std::move(new_value);
+  Commit(sequence);
+  return true;
+}
+
+template <typename T>
+int64_t BroadcastRing<T>::Claim() {
+  if (closed_.load(std::memory_order_acquire)) {
+    return -1;
+  }
+  int64_t sequence;
+  if (mode_ == ProducerMode::kSingle) {
+    sequence = claim_.value.load(std::memory_order_relaxed) + 1;
+    claim_.value.store(sequence, std::memory_order_relaxed);
+  } else {
+    sequence = claim_.value.fetch_add(1, std::memory_order_relaxed) + 1;
+  }
+  WaitForSpace(sequence);
+  return sequence;
+}
+
+template <typename T>
+void BroadcastRing<T>::Commit(int64_t sequence) {
+  if (mode_ == ProducerMode::kSingle) {
+    cursor_.value.store(sequence, std::memory_order_release);
+  } else {
+    published_[sequence & mask_].store(sequence >> shift_,
+                                       std::memory_order_release);
+  }
+  if (strategy_ != WaitStrategy::kBusySpin) {
+    NotifyConsumers();
+  }
+}
+
+template <typename T>
+void BroadcastRing<T>::WaitForSpace(int64_t sequence) {
+  // The slot is free once every gating consumer is past its previous lap
+  int64_t wrap_point = sequence - (mask_ + 1);
+  if (wrap_point <= gate_cache_.value.load(std::memory_order_acquire)) {
+    return;
+  }
+  Backoff backoff;
+  while (true) {
+    int64_t gate = MinGatingSequence();
+    gate_cache_.value.store(gate, std::memory_order_release);
+    if (wrap_point <= gate) {
+      return;
+    }
+    backoff.Pause();
+  }
+}
+
+template <typename T>
+int64_t BroadcastRing<T>::MinGatingSequence() const {
+  int64_t gate = std::numeric_limits<int64_t>::max();
+  for (size_t index : gating_) {
+    int64_t sequence =
+        consumers_[index]->sequence.value.load(std::memory_order_acquire);
+    gate = std::min(gate, sequence);
+  }
+  return gate;
+}
+
+template <typename T>
+inline void BroadcastRing<T>::NotifyConsumers() {
+  // Pairs with the fence in WaitFor: either this load sees the waiter, or
+  // the waiter sees the new event
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (waiting_consumers_.load(std::memory_order_relaxed) > 0) {
+    std::lock_guard<std::mutex> lk(wait_mutex_);
+    wait_cond_.notify_all();
+  }
+}
+
+template <typename T>
+int64_t BroadcastRing<T>::Published(int64_t next) const {
+  if (mode_ == ProducerMode::kSingle) {
+    return cursor_.value.load(std::memory_order_acquire);
+  }
+  int64_t claimed = claim_.value.load(std::memory_order_acquire);
+  for (int64_t sequence = next; sequence <= claimed; sequence++) {
+    if (published_[sequence & mask_].load(std::memory_order_acquire) !=
+        (sequence >> shift_)) {
+      return sequence - 1;
+    }
+  }
+  return claimed;
+}
+
+template <typename T>
+int64_t BroadcastRing<T>::Available(const Consumer& consumer,
+                                    int64_t next) const {
+  int64_t available = Published(next);
+  for (size_t dependency : consumer.depends_on) {
+    int64_t sequence =
+        consumers_[dependency]->sequence.value.load(std::memory_order_acquire);
+    available = std::min(available, sequence);
+  }
+  return available;
+}
+
+template <typename T>
+int64_t BroadcastRing<T>::WaitFor(const Consumer& consumer, int64_t next) {
+  Backoff backoff;
+  int spins = 0;
+  while (true) {
+    int64_t available = Available(consumer, next);
+    if (available >= next) {
+      return available;
+    }
+    // Events published before Close() are visible once it is, a consumer
+    // is done when it has them all, dependencies may still be draining
+    if (closed_.load(std::memory_order_acquire) && Published(next) < next) {
+      return next - 1;
+    }
+
+    bool park = strategy_ == WaitStrategy::kBlocking ||
+                (strategy_ == WaitStrategy::kSpinThenPark &&
+                 spins >= kSpinRounds);
+    if (park && Published(next) < next) {
+      std::unique_lock<std::mutex> lk(wait_mutex_);
+      waiting_consumers_.fetch_add(1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      while (Published(next) < next &&
+             !closed_.load(std::memory_order_acquire)) {
+        wait_cond_.wait(lk);
+      }
+      waiting_consumers_.fetch_sub(1, std::memory_order_relaxed);
+      continue;
+    }
+    if (strategy_ == WaitStrategy::kBusySpin) {
+      CpuRelax();
+    } else {
+      backoff.Pause();
+    }
+    spins++;
+  }
+}
+
+template <typename T>
+template <typename Handler>
+size_t BroadcastRing<T>::Run(Consumer& consumer, int64_t next,
+                             int64_t available, Handler& handler,
+                             size_t max_batch) {
+  if (available < next) {
+    return 0;
+  }
+  size_t count = static_cast<size_t>(available - next + 1);
+  if (count > max_batch) {
+    count = max_batch;
+    available = next + static_cast<int64_t>(count) - 1;
+  }
+  for (int64_t sequence = next; sequence <= available; sequence++) {
+    handler(entries_[sequence & mask_]);
+  }
+  consumer.sequence.value.store(available, std::memory_order_release);
+  return count;
+}
+
+template <typename T>
+template <typename Handler>
+size_t BroadcastRing<T>::Process(size_t consumer, Handler handler,
+                                 size_t max_batch) {
+  Consumer& state = *consumers_[consumer];
+  int64_t next = state.sequence.value.load(std::memory_order_relaxed) + 1;
+  return Run(state, next, WaitFor(state, next), handler, max_batch);
+}
+
+template <typename T>
+template <typename Handler>
+size_t BroadcastRing<T>::TryProcess(size_t consumer, Handler handler,
+                                    size_t max_batch) {
+  Consumer& state = *consumers_[consumer];
+  int64_t next = state.sequence.value.load(std::memory_order_relaxed) + 1;
+  return Run(state, next, Available(state, next), handler, max_batch);
+}
+
+template <typename T>
+bool BroadcastRing<T>::WaitAndRead(size_t consumer, T& value) {
+  return Process(consumer, [&value](const T& event) { value = event; }, 1) ==
+         1;
+}
+
+template <typename T>
+bool BroadcastRing<T>::TryRead(size_t consumer, T& value) {
+  return TryProcess(consumer, [&value](const T& event) { value = event; },
+                    1) == 1;
+}
+
+template <typename T>
+void BroadcastRing<T>::Close() {
+  closed_.store(true, std::memory_order_release);
+  std::lock_guard<std::mutex> lk(wait_mutex_);
+  wait_cond_.notify_all();
+}
+
+}  // namespace Utils
+
+#endif  // UTILS_BROADCAST_RING_H_
@@ -0,0 +1,224 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Double ended container storing elements by value in pooled chunks.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#ifndef UTILS_CHUNKED_RING_H_
+#define UTILS_CHUNKED_RING_H_
+
+#include <cstddef>
+#include <deque>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Utils {
+
+/**
+ * Elements live by value in fixed size chunks. A chunk drained at either end
+ * goes to a small spare list and is reused by the next push that needs one,
+ * so a queue in steady state does not allocate. Push and pop are O(1) at
+ * both ends. Not thread safe.
+ */
+template <typename T>
+class ChunkedRing {
+ public:
+  ChunkedRing() = default;
+
+  ChunkedRing(const ChunkedRing& other);
+
+  ChunkedRing(ChunkedRing&& other) { Swap(other); }
+
+  ChunkedRing& operator=(ChunkedRing other) {
+    Swap(other);
+    return *this;
+  }
+
+  ~ChunkedRing();
+
+  template <typename... Args>
+  void EmplaceBack(Args&&... args);
+
+  template <typename... Args>
+  void EmplaceFront(Args&&... args);
+
+  void PopFront();
+
+  void PopBack();
+
+  T& Front() { return *Slot(chunks_.front(), head_); }
+
+  T& Back() { return *Slot(chunks_.back(), tail_ - 1); }
+
+  T& operator[](size_t index);
+
+  const T& operator[](size_t index) const;
+
+  bool Empty() const { return size_ == 0; }
+
+  size_t Size() const { return size_; }
+
+  void Clear();
+
+  /**
+   * Exchange the elements only. Each ring keeps its own spare chunks, so a
+   * container drained by swapping with a temporary keeps its chunk cache.
+   */
+  void Swap(ChunkedRing& other);
+
+ private:
+  static const size_t kChunkSize =
+      sizeof(T) >= 128 ? 8 : 1024 / sizeof(T);
+  static const size_t kMaxSpareChunks = 4;
+
+  typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type Storage;
+
+  struct Chunk {
+    Storage items[kChunkSize];
+  };
+
+  static T* Slot(Chunk* chunk, size_t offset) {
+    return reinterpret_cast<T*>(&chunk->items[offset]);
+  }
+
+  Chunk* AcquireChunk();
+
+  void RecycleChunk(Chunk* chunk);
+
+  // Elements span [chunks_.front()[head_], chunks_.back()[tail_])
+  std::deque<Chunk*> chunks_;
+  std::vector<Chunk*> spare_chunks_;
+  size_t head_{0};
+  size_t tail_{0};
+  size_t size_{0};
+};
+
+template <typename T>
+ChunkedRing<T>::ChunkedRing(const ChunkedRing& other) {
+  for (size_t i = 0; i < other.size_; i++) {
+    EmplaceBack(other[i]);
+  }
+}
+
+template <typename T>
+ChunkedRing<T>::~ChunkedRing() {
+  Clear();
+  for (auto chunk : spare_chunks_) {
+    delete chunk;
+  }
+}
+
+template <typename T>
+template <typename... Args>
+inline void ChunkedRing<T>::EmplaceBack(Args&&... args) {
+  if (chunks_.empty()) {
+    chunks_.push_back(AcquireChunk());
+    head_ = tail_ = 0;
+  } else if (tail_ == kChunkSize) {
+    chunks_.push_back(AcquireChunk());
+    tail_ = 0;
+  }
+  new (Slot(chunks_.back(), tail_)) T(std::forward<Args>(args)...);
+  tail_++;
+  size_++;
+}
+
+template <typename T>
+template <typename... Args>
+inline void ChunkedRing<T>::EmplaceFront(Args&&... args) {
+  if (chunks_.empty()) {
+    chunks_.push_back(AcquireChunk());
+    head_ = tail_ = kChunkSize;
+  } else if (head_ == 0) {
+    chunks_.push_front(AcquireChunk());
+    head_ = kChunkSize;
+  }
+  new (Slot(chunks_.front(), head_ - 1)) T(std::forward<Args>(args)...);
+  head_--;
+  size_++;
+}
+
+template <typename T>
+inline void ChunkedRing<T>::PopFront() {
+  Slot(chunks_.front(), head_)->~T();
+  head_++;
+  size_--;
+  if (size_ == 0) {
+    RecycleChunk(chunks_.front());
+    chunks_.pop_front();
+    head_ = tail_ = 0;
+  } else if (head_ == kChunkSize) {
+    RecycleChunk(chunks_.front());
+    chunks_.pop_front();
+    head_ = 0;
+  }
+}
+
+template <typename T>
+inline void ChunkedRing<T>::PopBack() {
+  tail_--;
+  Slot(chunks_.back(), tail_)->~T();
+  size_--;
+  if (size_ == 0) {
+    RecycleChunk(chunks_.back());
+    chunks_.pop_back();
+    head_ = tail_ = 0;
+  } else if (tail_ == 0) {
+    RecycleChunk(chunks_.back());
+    chunks_.pop_back();
+    tail_ = kChunkSize;
+  }
+}
+
+template <typename T>
+T& ChunkedRing<T>::operator[](size_t index) {
+  size_t pos = head_ + index;
+  return *Slot(chunks_[pos / kChunkSize], pos % kChunkSize);
+}
+
+template <typename T>
+const T& ChunkedRing<T>::operator[](size_t index) const {
+  size_t pos = head_ + index;
+  return *Slot(chunks_[pos / kChunkSize], pos % kChunkSize);
+}
+
+template <typename T>
+void ChunkedRing<T>::Clear() {
+  while (size_ > 0) {
+    PopBack();
+  }
+}
+
+template <typename T>
+void ChunkedRing<T>::Swap(ChunkedRing& other) {
+  chunks_.swap(other.chunks_);
+  std::swap(head_, other.head_);
+  std::swap(tail_, other.tail_);
+  std::swap(size_, other.size_);
+}
+
+template <typename T>
+typename ChunkedRing<T>::Chunk* ChunkedRing<T>::AcquireChunk() {
+  if (spare_chunks_.empty()) {
+    return new Chunk;
+  }
+  Chunk* chunk = spare_chunks_.back();
+  spare_chunks_.pop_back();
+  return chunk;
+}
+
+template <typename T>
+void ChunkedRing<T>::RecycleChunk(Chunk* chunk) {
+  if (spare_chunks_.size() < kMaxSpareChunks) {
+    spare_chunks_.push_back(chunk);
+  } else {
+    delete chunk;
+  }
+}
+
+}  // namespace Utils
+
+#endif  // UTILS_CHUNKED_RING_H_
@@ -0,0 +1,303 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Thread safe keyed queue keeping only the latest value per key.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#ifndef UTILS_CONFLATING_QUEUE_H_
+#define UTILS_CONFLATING_QUEUE_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "chunked_ring.h"
+#include "queue_status.h"
+
+namespace Utils {
+
+/**
+ * Queue of key/value updates where a push for a key that is still queued
+ * replaces its value in place. Keys come out in the order they first
+ * arrived since last popped, each with its latest value, so a burst of
+ * updates for one key costs the consumer a single pop and memory is bounded
+ * by the number of distinct keys:
+ *
+ *   queue.Push("EURUSD", quote);
+ *   ...
+ *   while (queue.WaitAndPopAll(updates) > 0) { Publish(updates); ... }
+ *
+ * Only a push of a new key wakes a consumer.
+ */
+template <typename K, typename V, typename Hash = std::hash<K>,
+          typename KeyEqual = std::equal_to<K> >
+class ConflatingQueue {
+ public:
+  ConflatingQueue() = default;
+
+  ConflatingQueue(const ConflatingQueue& other) = delete;
+  ConflatingQueue& operator=(const ConflatingQueue& other) = delete;
+
+  /**
+   * @return false if the queue is closed, the value is dropped then
+   */
+  bool Push(const K& key, const V& value) { return Emplace(key, value); }
+
+  bool Push(const K& key, V&& value) {
+    return Emplace(key, std::move(value));
+  }
+
+  /**
+   * Block until a key is queued.
+   * @return false if the queue was closed and is drained
+   */
+  bool WaitAndPop(K& key, V& value);
+
+  template <typename Rep, typename Period>
+  QueueStatus WaitAndPopFor(K& key, V& value,
+                            const std::chrono::duration<Rep, Period>& timeout);
+
+  bool TryPop(K& key, V& value);
+
+  /**
+   * Move every queued update to the end of 'out' in arrival order. The
+   * queue is swapped out under the lock and drained after releasing it.
+   * @return number of updates popped
+   */
+  size_t PopAll(std::vector<std::pair<K, V> >& out);
+
+  /**
+   * Block until a key is queued, then PopAll().
+   * @return number of updates popped, zero once closed and drained
+   */
+  size_t WaitAndPopAll(std::vector<std::pair<K, V> >& out);
+
+  /**
+   * Reject further pushes and wake every waiter. Queued updates can still
+   * be popped.
+   */
+  void Close();
+
+  bool IsClosed() const;
+
+  bool IsEmpty() const;
+
+  void Clear();
+
+  /**
+   * @return number of queued keys
+   */
+  size_t Size() const;
+
+  /**
+   * @return number of values replaced before a consumer saw them
+   */
+  uint64_t GetConflatedCount() const;
+
+ private:
+  typedef std::unordered_map<K, V, Hash, KeyEqual> Map;
+  // Rehashing keeps element addresses, so the order ring can point into the
+  // map and a pop reaches the front entry without a lookup; only its erase
+  // hashes the key
+  typedef typename Map::value_type Entry;
+
+  template <typename U>
+  bool Emplace(const K& key, U&& value);
+
+  bool HasDataOrClosed() const { return !order_.Empty() || closed_; }
+
+  // Wait under 'lk', false on timeout
+  bool WaitForData(std::unique_lock<std::mutex>& lk,
+                   const std::chrono::steady_clock::time_point* deadline);
+
+  void PopLocked(K& key, V& value);
+
+  size_t PopAllLocked(std::unique_lock<std::mutex>& lk,
+                      std::vector<std::pair<K, V> >& out);
+
+  mutable std::mutex mut_;
+  Map values_;
+  ChunkedRing<Entry*> order_;
+  std::condition_variable data_cond_;
+  bool closed_{false};
+  // Consumers asleep on 'data_cond_', pushes skip the notify while zero
+  int waiting_consumers_{0};
+  uint64_t conflated_count_{0};
+};
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+template <typename U>
+bool ConflatingQueue<K, V, Hash, KeyEqual>::Emplace(const K& key,
+                                                    U&& value) {
+  std::unique_lock<std::mutex> lk(mut_);
+  if (closed_) {
+    return false;
+  }
+  auto found = values_.find(key);
+  if (found != values_.end()) {
+    found->second = std::forward<U>(value);
+    conflated_count_++;
+    return true;
+  }
+  auto inserted = values_.emplace(key, std::forward<U>(value));
+  order_.EmplaceBack(&*inserted.first);
+  if (waiting_consumers_ == 0) {
+    return true;
+  }
+  // A woken consumer must not block on the mutex still held here
+  lk.unlock();
+  data_cond_.notify_one();
+  return true;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+bool ConflatingQueue<K, V, Hash, KeyEqual>::WaitForData(
+    std::unique_lock<std::mutex>& lk,
+    const std::chrono::steady_clock::time_point* deadline) {
+  if (HasDataOrClosed()) {
+    return true;
+  }
+  waiting_consumers_++;
+  bool ready = true;
+  if (deadline) {
+    ready = data_cond_.wait_until(lk, *deadline,
+                                  [this] { return HasDataOrClosed(); });
+  } else {
+    data_cond_.wait(lk, [this] { return HasDataOrClosed(); });
+  }
+  waiting_consumers_--;
+  return ready;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+inline void ConflatingQueue<K, V, Hash, KeyEqual>::PopLocked(K& key,
+                                                             V& value) {
+  Entry* entry = order_.Front();
+  order_.PopFront();
+  key = entry->first;
+  value = std::move(entry->second);
+  values_.erase(key);
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+bool ConflatingQueue<K, V, Hash, KeyEqual>::WaitAndPop(K& key, V& value) {
+  std::unique_lock<std::mutex> lk(mut_);
+  WaitForData(lk, nullptr);
+  if (order_.Empty()) {
+    return false;
+  }
+  PopLocked(key, value);
+  return true;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+template <typename Rep, typename Period>
+QueueStatus ConflatingQueue<K, V, Hash, KeyEqual>::WaitAndPopFor(
+    K& key, V& value, const std::chrono::duration<Rep, Period>& timeout) {
+  std::chrono::steady_clock::time_point deadline =
+      std::chrono::steady_clock::now() +
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout);
+  std::unique_lock<std::mutex> lk(mut_);
+  if (!WaitForData(lk, &deadline)) {
+    return QueueStatus::kTimeout;
+  }
+  if (order_.Empty()) {
+    return QueueStatus::kClosed;
+  }
+  PopLocked(key, value);
+  return QueueStatus::kSuccess;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+bool ConflatingQueue<K, V, Hash, KeyEqual>::TryPop(K& key, V& value) {
+  std::lock_guard<std::mutex> lk(mut_);
+  if (order_.Empty()) {
+    return false;
+  }
+  PopLocked(key, value);
+  return true;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+size_t ConflatingQueue<K, V, Hash, KeyEqual>::PopAllLocked(
+    std::unique_lock<std::mutex>& lk, std::vector<std::pair<K, V> >& out) {
+  Map values;
+  ChunkedRing<Entry*> order;
+  values.swap(values_);
+  order.Swap(order_);
+  lk.unlock();
+
+  size_t count = order.Size();
+  out.reserve(out.size() + count);
+  while (!order.Empty()) {
+    Entry* entry = order.Front();
+    order.PopFront();
+    out.emplace_back(entry->first, std::move(entry->second));
+  }
+  return count;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+size_t ConflatingQueue<K, V, Hash, KeyEqual>::PopAll(
+    std::vector<std::pair<K, V> >& out) {
+  std::unique_lock<std::mutex> lk(mut_);
+  return PopAllLocked(lk, out);
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+size_t ConflatingQueue<K, V, Hash, KeyEqual>::WaitAndPopAll(
+    std::vector<std::pair<K, V> >& out) {
+  std::unique_lock<std::mutex> lk(mut_);
+  WaitForData(lk, nullptr);
+  return PopAllLocked(lk, out);
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+void ConflatingQueue<K, V, Hash, KeyEqual>::Close() {
+  {
+    std::lock_guard<std::mutex> lk(mut_);
+    closed_ = true;
+  }
+  data_cond_.notify_all();
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+bool ConflatingQueue<K, V, Hash, KeyEqual>::IsClosed() const {
+  std::lock_guard<std::mutex> lk(mut_);
+  return closed_;
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+bool ConflatingQueue<K, V, Hash, KeyEqual>::IsEmpty() const {
+  std::lock_guard<std::mutex> lk(mut_);
+  return order_.Empty();
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+void ConflatingQueue<K, V, Hash, KeyEqual>::Clear() {
+  std::lock_guard<std::mutex> lk(mut_);
+  order_.Clear();
+  values_.clear();
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+size_t ConflatingQueue<K, V, Hash, KeyEqual>::Size() const {
+  std::lock_guard<std::mutex> lk(mut_);
+  return order_.Size();
+}
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+uint64_t ConflatingQueue<K, V, Hash, KeyEqual>::GetConflatedCount() const {
+  std::lock_guard<std::mutex> lk(mut_);
+  return conflated_count_;
+}
+
+}  // namespace Utils
+
+#endif  // UTILS_CONFLATING_QUEUE_H_
@@ -0,0 +1,150 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Implicit d-ary heap over a contiguous vector.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#ifndef UTILS_DARY_HEAP_H_
+#define UTILS_DARY_HEAP_H_
+
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace Utils {
+
+/**
+ * Same ordering as std::priority_queue: Top() is the element that compares
+ * greatest under 'Compare', so std::greater<> gives a min-heap. With D
+ * children per node the tree is log_D(n) deep and the children of a node are
+ * adjacent in memory, which suits large heaps better than a binary heap. Not
+ * thread safe.
+ */
+template <typename T, typename Compare = std::less<T>, size_t D = 4>
+class DaryHeap {
+ public:
+  static_assert(D >= 2, "a heap node needs at least two children");
+
+  explicit DaryHeap(const Compare& comp = Compare()) : comp_(comp) {}
+
+  /**
+   * @return true if the new element is now on top
+   */
+  bool Push(const T& value) { return Emplace(value); }
+
+  bool Push(T&& value) { return Emplace(std::move(value)); }
+
+  template <typename... Args>
+  bool Emplace(Args&&... args);
+
+  const T& Top() const { return items_.front(); }
+
+  /**
+   * Move the top element into 'value' and remove it.
+   */
+  void Pop(T& value);
+
+  T PopTop();
+
+  void Pop();
+
+  bool Empty() const { return items_.empty(); }
+
+  size_t Size() const { return items_.size(); }
+
+  void Reserve(size_t count) { items_.reserve(count); }
+
+  void Clear() { items_.clear(); }
+
+  void Swap(DaryHeap& other) {
+    items_.swap(other.items_);
+    std::swap(comp_, other.comp_);
+  }
+
+ private:
+  // Returns the index the element settled at
+  size_t SiftUp(size_t index);
+
+  void SiftDown(size_t index);
+
+  std::vector<T> items_;
+  Compare comp_;
+};
+
+template <typename T, typename Compare, size_t D>
+template <typename... Args>
+inline bool DaryHeap<T, Compare, D>::Emplace(Args&&... args) {
+  items_.emplace_back(std::forward<Args>(args)...);
+  return SiftUp(items_.size() - 1) == 0;
+}
+
+template <typename T, typename Compare, size_t D>
+inline void DaryHeap<T, Compare, D>::Pop(T& value) {
+  value = std::move(items_.front());
+  Pop();
+}
+
+template <typename T, typename Compare, size_t D>
+inline T DaryHeap<T, Compare, D>::PopTop() {
+  T value = std::move(items_.front());
+  Pop();
+  return value;
+}
+
+template <typename T, typename Compare, size_t D>
+inline void DaryHeap<T, Compare, D>::Pop() {
+  if (items_.size() > 1) {
+    items_.front() = std::move(items_.back());
+    items_.pop_back();
+    SiftDown(0);
+  } else {
+    items_.pop_back();
+  }
+}
+
+template <typename T, typename Compare, size_t D>
+size_t DaryHeap<T, Compare, D>::SiftUp(size_t index) {
+  // Shift parents down into the hole and place the element once
+  T value = std::move(items_[index]);
+  while (index > 0) {
+    size_t parent = (index - 1) / D;
+    if (!comp_(items_[parent], value)) {
+      break;
+    }
+    items_[index] = std::move(items_[parent]);
+    index = parent;
+  }
+  items_[index] = std::move(value);
+  return index;
+}
+
+template <typename T, typename Compare, size_t D>
+void DaryHeap<T, Compare, D>::SiftDown(size_t index) {
+  size_t size = items_.size();
+  T value = std::move(items_[index]);
+  while (true) {
+    size_t first = index * D + 1;
+    if (first >= size) {
+      break;
+    }
+    size_t last = first + D < size ? first + D : size;
+    size_t best = first;
+    for (size_t child = first + 1; child < last; child++) {
+      if (comp_(items_[best], items_[child])) {
+        best = child;
+      }
+    }
+    if (!comp_(value, items_[best])) {
+      break;
+    }
+    items_[index] = std::move(items_[best]);
+    index = best;
+  }
+  items_[index] = std::move(value);
+}
+
+}  // namespace Utils
+
+#endif  // UTILS_DARY_HEAP_H_
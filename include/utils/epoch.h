@@ -0,0 +1,174 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Epoch based memory reclamation for lock-free containers.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#ifndef UTILS_EPOCH_H_
+#define UTILS_EPOCH_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "lock_free_common.h"
+#include "mempool.h"
+
+namespace Utils {
+
+/**
+ * Process wide epoch based reclamation domain.
+ *
+ * A reader pins the current thread with an Epoch::Guard before touching
+ * shared nodes, and a writer that unlinked a node hands it to Retire() instead
+ * of freeing it. A retired node is reclaimed once the global epoch moved two
+ * steps forward, i.e. when every thread that could still see it has left its
+ * critical section. Retired nodes are buffered per thread and reclaimed in
+ * batches, so the cost of a guard is one store and one fence.
+ */
+class Epoch {
+ public:
+  typedef void (*Reclaimer)(void *ptr, void *ctx);
+
+  /**
+   * RAII critical section. Guards may nest; only the outermost one publishes
+   * the thread's epoch.
+   */
+  class Guard {
+   public:
+    Guard() { Enter(); }
+    ~Guard() { Exit(); }
+
+    Guard(const Guard &other) = delete;
+    Guard &operator=(const Guard &other) = delete;
+  };
+
+  static void Enter();
+
+  static void Exit();
+
+  /**
+   * Defer 'reclaim(ptr, ctx)' until no pinned thread can reference 'ptr'.
+   */
+  static void Retire(void *ptr, Reclaimer reclaim, void *ctx);
+
+  /**
+   * Defer 'delete ptr'.
+   */
+  template <typename T>
+  static void Retire(T *ptr);
+
+  /**
+   * Defer returning 'ptr' to 'pool' instead of deleting it. The pool must
+   * outlive every node retired into it.
+   */
+  template <typename T>
+  static void Retire(T *ptr, const std::shared_ptr<MemPoolEx<T> > &pool);
+
+  /**
+   * Try to advance the global epoch and reclaim what became safe on this
+   * thread.
+   * @return number of reclaimed nodes
+   */
+  static size_t Collect();
+
+  /**
+   * Block until every node retired so far by this thread is reclaimed. Must
+   * not be called inside a guard.
+   */
+  static void Synchronize();
+
+  static uint64_t GetGlobalEpoch();
+
+  /**
+   * Number of nodes retired by this thread and not yet reclaimed.
+   */
+  static size_t GetPendingCount();
+
+ private:
+  struct Retired {
+    void *ptr;
+    Reclaimer reclaim;
+    void *ctx;
+    uint64_t epoch;
+  };
+
+  struct Record {
+    // Kept on its own cache line, polled by every advancing thread
+    char padding0[kCacheLineSize];
+    // (epoch << 1) | active, written by the owner and read by advancers
+    std::atomic<uint64_t> state{0};
+    char padding1[kCacheLineSize - sizeof(std::atomic<uint64_t>)];
+    std::atomic<bool> in_use{false};
+    Record *next{nullptr};
+    unsigned nesting{0};
+    unsigned retired_since_collect{0};
+    std::vector<Retired> retired;
+  };
+
+  struct ThreadHandle {
+    Record *record{nullptr};
+    ~ThreadHandle();
+  };
+
+  static const unsigned kCollectThreshold = 64;
+
+  Epoch() = default;
+
+  static Epoch &Instance();
+
+  static Record *LocalRecord();
+
+  Record *AcquireRecord();
+
+  void ReleaseRecord(Record *record);
+
+  bool TryAdvance();
+
+  size_t Reclaim(std::vector<Retired> *retired);
+
+  size_t CollectOrphans();
+
+  template <typename T>
+  static void DeleteReclaimer(void *ptr, void *ctx);
+
+  template <typename T>
+  static void PoolReclaimer(void *ptr, void *ctx);
+
+  std::atomic<uint64_t> global_epoch_{0};
+  std::atomic<Record *> records_{nullptr};
+
+  // Nodes left behind by exited threads
+  std::mutex orphan_mutex_;
+  std::vector<Retired> orphans_;
+
+  static thread_local ThreadHandle handle_;
+};  // class Epoch
+
+template <typename T>
+void Epoch::Retire(T *ptr) {
+  Retire(ptr, &Epoch::DeleteReclaimer<T>, nullptr);
+}
+
+template <typename T>
+void Epoch::Retire(T *ptr, const std::shared_ptr<MemPoolEx<T> > &pool) {
+  Retire(ptr, &Epoch::PoolReclaimer<T>, pool.get());
+}
+
+template <typename T>
+void Epoch::DeleteReclaimer(void *ptr, void * /*ctx*/) {
+  delete static_cast<T *>(ptr);
+}
+
+template <typename T>
+void Epoch::PoolReclaimer(void *ptr, void *ctx) {
+  static_cast<MemPoolEx<T> *>(ctx)->Release(static_cast<T *>(ptr));
+}
+
+}  // namespace Utils
+
+#endif  // UTILS_EPOCH_H_
@@ -0,0 +1,50 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief QueueNotifier signalling a Linux eventfd.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#ifndef UTILS_EVENT_FD_NOTIFIER_H_
+#define UTILS_EVENT_FD_NOTIFIER_H_
+
+#include "queue_notifier.h"
+
+namespace Utils {
+
+/**
+ * Owns a non-blocking eventfd that becomes readable on Notify(), so a queue
+ * can be registered with epoll/poll next to sockets and timers. Linux only;
+ * elsewhere GetFd() returns -1 and Notify() does nothing.
+ */
+class EventFdNotifier : public QueueNotifier {
+ public:
+  EventFdNotifier();
+
+  ~EventFdNotifier() override;
+
+  EventFdNotifier(const EventFdNotifier &other) = delete;
+  EventFdNotifier &operator=(const EventFdNotifier &other) = delete;
+
+  void Notify() override;
+
+  /**
+   * Reset the descriptor to not readable. Call before draining the queue,
+   * so a push racing with the drain leaves it readable again.
+   */
+  void Consume();
+
+  /**
+   * @return the descriptor to poll for EPOLLIN, -1 if creation failed
+   */
+  int GetFd() const { return fd_; }
+
+  bool IsValid() const { return fd_ >= 0; }
+
+ private:
+  int fd_{-1};
+};  // class EventFdNotifier
+
+}  // namespace Utils
+
+#endif  // UTILS_EVENT_FD_NOTIFIER_H_
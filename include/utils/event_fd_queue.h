@@ -0,0 +1,100 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Thread safe queue exposing a pollable file descriptor.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#ifndef UTILS_EVENT_FD_QUEUE_H_
+#define UTILS_EVENT_FD_QUEUE_H_
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "event_fd_notifier.h"
+#include "thread_safe_queue.h"
+
+namespace Utils {
+
+/**
+ * ThreadSafeQueue for consumers running an epoll/poll loop instead of
+ * blocking in WaitAndPop. Register GetFd() for EPOLLIN; when it fires, call
+ * Drain(). Producers only write to the eventfd when the queue was empty, so
+ * a busy queue costs no extra system call per push.
+ */
+template <typename T, typename Storage = ValueStorage>
+class EventFdQueue {
+ public:
+  EventFdQueue() { queue_.SetNotifier(&notifier_); }
+
+  explicit EventFdQueue(size_t capacity,
+                        OverflowPolicy policy = OverflowPolicy::kBlock)
+      : queue_(capacity, policy) {
+    queue_.SetNotifier(&notifier_);
+  }
+
+  EventFdQueue(const EventFdQueue& other) = delete;
+  EventFdQueue& operator=(const EventFdQueue& other) = delete;
+
+  /**
+   * @return -1 if the eventfd could not be created
+   */
+  int GetFd() const { return notifier_.GetFd(); }
+
+  bool Push(const T& new_value) { return queue_.Push(new_value); }
+
+  bool Push(T&& new_value) { return queue_.Push(std::move(new_value)); }
+
+  template <typename... Args>
+  bool Emplace(Args&&... args) {
+    return queue_.Emplace(std::forward<Args>(args)...);
+  }
+
+  template <typename InputIt>
+  bool PushRange(InputIt first, InputIt last) {
+    return queue_.PushRange(first, last);
+  }
+
+  /**
+   * Reset the descriptor and move at most 'max_count' elements to 'out'. If
+   * elements are left behind the descriptor is made readable again, so the
+   * loop comes back for them.
+   * @return number of elements popped
+   */
+  size_t Drain(std::vector<T>& out, size_t max_count = static_cast<size_t>(-1));
+
+  bool TryPop(T& value) { return queue_.TryPop(value); }
+
+  void Close() { queue_.Close(); }
+
+  bool IsClosed() const { return queue_.IsClosed(); }
+
+  bool IsEmpty() const { return queue_.IsEmpty(); }
+
+  size_t Size() const { return queue_.Size(); }
+
+  ThreadSafeQueue<T, Storage>& GetQueue() { return queue_; }
+
+ private:
+  // Declared first, the queue may call it until it is destroyed
+  EventFdNotifier notifier_;
+  ThreadSafeQueue<T, Storage> queue_;
+};
+
+template <typename T, typename Storage>
+size_t EventFdQueue<T, Storage>::Drain(std::vector<T>& out, size_t max_count) {
+  notifier_.Consume();
+  if (max_count == static_cast<size_t>(-1)) {
+    return queue_.PopAll(out);
+  }
+  size_t count = queue_.PopUpTo(out, max_count);
+  if (count == max_count && !queue_.IsEmpty()) {
+    notifier_.Notify();
+  }
+  return count;
+}
+
+}  // namespace Utils
+
+#endif  // UTILS_EVENT_FD_QUEUE_H_
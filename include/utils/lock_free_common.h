@@ -0,0 +1,76 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Small helpers shared by the lock-free containers.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#ifndef UTILS_LOCK_FREE_COMMON_H_
+#define UTILS_LOCK_FREE_COMMON_H_
+
+#include <cstddef>
+#include <thread>
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#endif
+
+namespace Utils {
+
+/**
+ * Assumed size of a cache line. Hot fields written by different threads are
+ * separated by at least this many bytes to avoid false sharing.
+ */
+constexpr size_t kCacheLineSize = 64;
+
+/**
+ * Hint the CPU that the caller is in a spin loop.
+ */
+inline void CpuRelax() {
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+  _mm_pause();
+#elif defined(__i386__) || defined(__x86_64__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+  asm volatile("yield" ::: "memory");
+#endif
+}
+
+/**
+ * Exponential backoff for retry loops: spins with pause instructions first,
+ * then yields the time slice once the spin budget is exhausted.
+ */
+class Backoff {
+ public:
+  void Pause() {
+    if (step_ <= kSpinLimit) {
+      for (unsigned i = 0; i < (1u << step_); i++) {
+        CpuRelax();
+      }
+      step_++;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+
+  void Reset() { step_ = 0; }
+
+ private:
+  static const unsigned kSpinLimit = 6;
+  unsigned step_{0};
+};
+
+/**
+ * Round 'value' up to the next power of two, at least 2.
+ */
+inline size_t RoundUpPowerOfTwo(size_t value) {
+  size_t result = 2;
+  while (result < value) {
+    result <<= 1;
+  }
+  return result;
+}
+
+}  // namespace Utils
+
+#endif  // UTILS_LOCK_FREE_COMMON_H_
@@ -0,0 +1,366 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Unbounded multi-producer single-consumer queues with a wait-free
+ * push.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#ifndef UTILS_MPSC_QUEUE_H_
+#define UTILS_MPSC_QUEUE_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "lock_free_common.h"
+
+namespace Utils {
+
+/**
+ * Link field for IntrusiveMpscQueue, embedded by deriving from it:
+ *
+ *   struct Message : public Utils::MpscHook { int type; ... };
+ *
+ * Copies start unlinked.
+ */
+struct MpscHook {
+  MpscHook() = default;
+
+  MpscHook(const MpscHook& /*other*/) {}
+
+  MpscHook& operator=(const MpscHook& /*other*/) { return *this; }
+
+  std::atomic<MpscHook*> mpsc_next{nullptr};
+};
+
+/**
+ * Vyukov's node based MPSC queue over items that derive from MpscHook, e.g.
+ * an actor mailbox. Push() is one atomic exchange plus one store, wait-free
+ * for any number of producers; only the single consumer may pop. The queue
+ * never allocates and does not own its items, an item must stay alive until
+ * it is popped.
+ *
+ * A producer preempted between its exchange and its link hides the items
+ * pushed after it, so TryPop() can briefly fail on a non-empty queue.
+ * WaitAndPop() covers that by spinning.
+ *
+ * With 'blocking' set, WaitAndPop() parks the consumer after a short spin
+ * and producers signal it only when it is asleep, at the cost of one fence
+ * per push, as in SpscQueue.
+ */
+template <typename T>
+class IntrusiveMpscQueue {
+ public:
+  static_assert(std::is_base_of<MpscHook, T>::value,
+                "items must derive from MpscHook");
+
+  explicit IntrusiveMpscQueue(bool blocking = false);
+
+  IntrusiveMpscQueue(const IntrusiveMpscQueue& other) = delete;
+  IntrusiveMpscQueue& operator=(const IntrusiveMpscQueue& other) = delete;
+
+  /**
+   * Any thread. 'item' must not be in a queue already.
+   */
+  void Push(T* item);
+
+  /**
+   * Consumer only.
+   * @return the oldest item, nullptr if none is visible yet
+   */
+  T* TryPop();
+
+  /**
+   * Consumer only, spin and yield, or park in blocking mode, until an item
+   * arrives.
+   */
+  T* WaitAndPop();
+
+  /**
+   * Consumer only, approximate while producers push.
+   */
+  bool IsEmpty() const;
+
+ private:
+  void PushHook(MpscHook* hook);
+
+  void NotifyConsumer();
+
+  // Sits in the queue whenever the consumer has taken every item, so the
+  // queue is never truly empty and producers never touch 'head_'
+  MpscHook stub_;
+  const bool blocking_;
+
+  // Producer side
+  char padding0_[kCacheLineSize];
+  std::atomic<MpscHook*> tail_;
+  char padding1_[kCacheLineSize - sizeof(std::atomic<MpscHook*>)];
+
+  // Consumer side
+  MpscHook* head_;
+  char padding2_[kCacheLineSize - sizeof(MpscHook*)];
+
+  // Only used in blocking mode
+  std::atomic<bool> consumer_waiting_{false};
+  std::mutex wait_mutex_;
+  std::condition_variable wait_cond_;
+};
+
+template <typename T>
+IntrusiveMpscQueue<T>::IntrusiveMpscQueue(bool blocking)
+    : blocking_(blocking), tail_(&stub_), head_(&stub_) {}
+
+template <typename T>
+inline void IntrusiveMpscQueue<T>::Push(T* item) {
+  PushHook(item);
+  if (blocking_) {
+    NotifyConsumer();
+  }
+}
+
+template <typename T>
+inline void IntrusiveMpscQueue<T>::PushHook(MpscHook* hook) {
+  hook->mpsc_next.store(nullptr, std::memory_order_relaxed);
+  MpscHook* prev = tail_.exchange(hook, std::memory_order_acq_rel);
+  prev->mpsc_next.store(hook, std::memory_order_release);
+}
+
+template <typename T>
+T* IntrusiveMpscQueue<T>::TryPop() {
+  MpscHook* head = head_;
+  MpscHook* next = head->mpsc_next.load(std::memory_order_acquire);
+  if (head == &stub_) {
+    if (next == nullptr) {
+      return nullptr;
+    }
+    head_ = next;
+    head = next;
+    next = next->mpsc_next.load(std::memory_order_acquire);
+  }
+  if (next) {
+    head_ = next;
+    return static_cast<T*>(head);
+  }
+  if (head != tail_.load(std::memory_order_acquire)) {
+    // A producer has swapped the tail but not linked its item yet
+    return nullptr;
+  }
+  // 'head' is the last item, put the stub behind it so it can be unlinked
+  PushHook(&stub_);
+  next = head->mpsc_next.load(std::memory_order_acquire);
+  if (next) {
+    head_ = next;
+    return static_cast<T*>(head);
+  }
+  return nullptr;
+}
+
+template <typename T>
+T* IntrusiveMpscQueue<T>::WaitAndPop() {
+  Backoff backoff;
+  T* item;
+  for (int i = 0; i < 16; i++) {
+    if ((item = TryPop()) != nullptr) {
+      return item;
+    }
+    backoff.Pause();
+  }
+  if (!blocking_) {
+    while ((item = TryPop()) == nullptr) {
+      backoff.Pause();
+    }
+    return item;
+  }
+
+  std::unique_lock<std::mutex> lk(wait_mutex_);
+  consumer_waiting_.store(true, std::memory_order_relaxed);
+  // Pairs with the fence in NotifyConsumer: either the producer sees the
+  // flag, or TryPop below sees the linked item.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  while ((item = TryPop()) == nullptr) {
+    wait_cond_.wait(lk);
+  }
+  consumer_waiting_.store(false, std::memory_order_relaxed);
+  return item;
+}
+
+template <typename T>
+inline void IntrusiveMpscQueue<T>::NotifyConsumer() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (consumer_waiting_.load(std::memory_order_relaxed)) {
+    std::lock_guard<std::mutex> lk(wait_mutex_);
+    wait_cond_.notify_one();
+  }
+}
+
+template <typename T>
+bool IntrusiveMpscQueue<T>::IsEmpty() const {
+  return head_ == &stub_ &&
+         stub_.mpsc_next.load(std::memory_order_acquire) == nullptr;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/**
+ * Value based MPSC queue on top of IntrusiveMpscQueue, for payloads that do
+ * not embed an MpscHook. Each element takes one node. With 'pre_alloc' > 0
+ * that many nodes are allocated up front in one slab and recycled through a
+ * lock-free free stack, so a push only allocates once the slab is used up;
+ * taking a node costs a CAS, so the push is lock-free rather than wait-free.
+ * Otherwise nodes come from new and delete.
+ */
+template <typename T>
+class MpscQueue {
+ public:
+  explicit MpscQueue(int pre_alloc = 0, bool blocking = false);
+
+  ~MpscQueue();
+
+  MpscQueue(const MpscQueue& other) = delete;
+  MpscQueue& operator=(const MpscQueue& other) = delete;
+
+  void Push(const T& new_value) { Emplace(new_value); }
+
+  void Push(T&& new_value) { Emplace(std::move(new_value)); }
+
+  template <typename... Args>
+  void Emplace(Args&&... args);
+
+  /**
+   * Consumer only.
+   */
+  bool TryPop(T& value);
+
+  void WaitAndPop(T& value);
+
+  bool IsEmpty() const { return queue_.IsEmpty(); }
+
+ private:
+  static const uint32_t kNoSlot = 0xFFFFFFFF;
+
+  struct Node : public MpscHook {
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    // Index in 'slab_', kNoSlot for nodes from new
+    uint32_t slot{kNoSlot};
+    // Next slot while on the free stack
+    std::atomic<uint32_t> next_free{kNoSlot};
+
+    T* Value() { return reinterpret_cast<T*>(&storage); }
+  };
+
+  Node* NewNode();
+
+  // Consumer only
+  void FreeNode(Node* node);
+
+  // Move the value out and free the node
+  void Take(Node* node, T& value);
+
+  IntrusiveMpscQueue<Node> queue_;
+  std::unique_ptr<Node[]> slab_;
+
+  // Free slab slots, (tag << 32) | slot. The tag changes on every update so
+  // a producer's CAS fails if the top was popped and pushed back meanwhile.
+  char padding0_[kCacheLineSize];
+  std::atomic<uint64_t> free_head_{kNoSlot};
+  char padding1_[kCacheLineSize - sizeof(std::atomic<uint64_t>)];
+};
+
+template <typename T>
+MpscQueue<T>::MpscQueue(int pre_alloc, bool blocking) : queue_(blocking) {
+  if (pre_alloc <= 0) {
+    return;
+  }
+  uint32_t count = static_cast<uint32_t>(pre_alloc);
+  slab_.reset(new Node[count]);
+  for (uint32_t i = 0; i < count; i++) {
+    slab_[i].slot = i;
+    slab_[i].next_free.store(i + 1 < count ? i + 1 : kNoSlot,
+                             std::memory_order_relaxed);
+  }
+  free_head_.store(0, std::memory_order_relaxed);
+}
+
+template <typename T>
+MpscQueue<T>::~MpscQueue() {
+  Node* node;
+  while ((node = queue_.TryPop()) != nullptr) {
+    node->Value()->~T();
+    FreeNode(node);
+  }
+}
+
+template <typename T>
+inline typename MpscQueue<T>::Node* MpscQueue<T>::NewNode() {
+  uint64_t head = free_head_.load(std::memory_order_acquire);
+  while (true) {
+    uint32_t slot = static_cast<uint32_t>(head);
+    if (slot == kNoSlot) {
+      return new Node();
+    }
+    // May be stale if another producer took 'slot', the CAS fails then
+    uint32_t next = slab_[slot].next_free.load(std::memory_order_relaxed);
+    uint64_t desired = (((head >> 32) + 1) << 32) | next;
+    if (free_head_.compare_exchange_weak(head, desired,
+                                         std::memory_order_acquire,
+                                         std::memory_order_acquire)) {
+      return &slab_[slot];
+    }
+  }
+}
+
+template <typename T>
+inline void MpscQueue<T>::FreeNode(Node* node) {
+  if (node->slot == kNoSlot) {
+    delete node;
+    return;
+  }
+  uint64_t head = free_head_.load(std::memory_order_relaxed);
+  uint64_t desired;
+  do {
+    node->next_free.store(static_cast<uint32_t>(head),
+                          std::memory_order_relaxed);
+    desired = (((head >> 32) + 1) << 32) | node->slot;
+  } while (!free_head_.compare_exchange_weak(head, desired,
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed));
+}
+
+template <typename T>
+template <typename... Args>
+inline void MpscQueue<T>::Emplace(Args&&... args) {
+  Node* node = NewNode();
+  new (node->Value()) T(std::forward<Args>(args)...);
+  queue_.Push(node);
+}
+
+template <typename T>
+inline void MpscQueue<T>::Take(Node* node, T& value) {
+  value = std::move(*node->Value());
+  node->Value()->~T();
+  FreeNode(node);
+}
+
+template <typename T>
+inline bool MpscQueue<T>::TryPop(T& value) {
+  Node* node = queue_.TryPop();
+  if (node == nullptr) {
+    return false;
+  }
+  Take(node, value);
+  return true;
+}
+
+template <typename T>
+void MpscQueue<T>::WaitAndPop(T& value) {
+  Take(queue_.WaitAndPop(), value);
+}
+
+}  // namespace Utils
+
+#endif  // UTILS_MPSC_QUEUE_H_
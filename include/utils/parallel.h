@@ -0,0 +1,217 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Fork-join parallel algorithms on top of ThreadPool.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#ifndef UTILS_PARALLEL_H_
+#define UTILS_PARALLEL_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <iterator>
+
+#include "thread_pool.h"
+
+namespace Utils {
+
+/**
+ * Every algorithm splits its range in halves recursively. One half is
+ * submitted to the pool and the calling thread keeps the other, so idle
+ * workers steal the big untouched halves first and the split adapts to
+ * uneven work. While waiting for the submitted half, a pool worker runs
+ * tasks from its own deque, see ThreadPool::Await(); a caller outside the
+ * pool only blocks. Ranges at or below 'grain' run sequentially; a grain of
+ * zero picks about eight chunks per worker.
+ *
+ * The overloads without a pool use GetDefaultThreadPool(). An exception thrown
+ * by a body is rethrown to the caller once every chunk has finished.
+ */
+
+/**
+ * Process wide pool with one worker per hardware thread, created on first
+ * use.
+ */
+ThreadPool &GetDefaultThreadPool();
+
+namespace detail {
+
+template <typename Index>
+Index AutoGrain(const ThreadPool &pool, Index first, Index last, Index grain) {
+  if (grain > 0) {
+    return grain;
+  }
+  Index chunks = static_cast<Index>(pool.GetThreadCount() * 8);
+  Index auto_grain = (last - first) / (chunks > 0 ? chunks : 1);
+  return auto_grain > 0 ? auto_grain : 1;
+}
+
+// Run 'left' here and 'right' on the pool, rejoining even if 'left' throws
+template <typename Left, typename Right>
+void ForkJoin(ThreadPool &pool, const Left &left, const Right &right) {
+  std::future<void> future = pool.Submit(right);
+  if (!future.valid()) {
+    // Pool shut down, stay sequential
+    left();
+    right();
+    return;
+  }
+  try {
+    left();
+  } catch (...) {
+    pool.Await(future);
+    throw;
+  }
+  pool.Await(future);
+  future.get();
+}
+
+template <typename Index, typename Fn>
+void ParallelForRange(ThreadPool &pool, Index first, Index last, Index grain,
+                      const Fn &fn) {
+  if (last - first <= grain) {
+    fn(first, last);
+    return;
+  }
+  Index mid = first + (last - first) / 2;
+  ForkJoin(pool, [&] { ParallelForRange(pool, first, mid, grain, fn); },
+           [&] { ParallelForRange(pool, mid, last, grain, fn); });
+}
+
+template <typename T, typename Index, typename RangeFn, typename Combine>
+T ParallelReduceRange(ThreadPool &pool, Index first, Index last, Index grain,
+                      const T &identity, const RangeFn &reduce_range,
+                      const Combine &combine) {
+  if (last - first <= grain) {
+    return reduce_range(first, last);
+  }
+  Index mid = first + (last - first) / 2;
+  T left = identity;
+  T right = identity;
+  ForkJoin(pool,
+           [&] {
+             left = ParallelReduceRange(pool, first, mid, grain, identity,
+                                        reduce_range, combine);
+           },
+           [&] {
+             right = ParallelReduceRange(pool, mid, last, grain, identity,
+                                         reduce_range, combine);
+           });
+  return combine(left, right);
+}
+
+template <typename RandomIt, typename Compare>
+void ParallelMergeSort(ThreadPool &pool, RandomIt first, RandomIt last,
+                       ptrdiff_t grain, const Compare &comp) {
+  if (last - first <= grain) {
+    std::sort(first, last, comp);
+    return;
+  }
+  RandomIt mid = first + (last - first) / 2;
+  ForkJoin(pool, [&] { ParallelMergeSort(pool, first, mid, grain, comp); },
+           [&] { ParallelMergeSort(pool, mid, last, grain, comp); });
+  std::inplace_merge(first, mid, last, comp);
+}
+
+}  // namespace detail
+
+/**
+ * Call 'fn(begin, end)' on disjoint sub-ranges covering [first, last).
+ */
+template <typename Index, typename Fn>
+void ParallelFor(ThreadPool &pool, Index first, Index last, Index grain,
+                 const Fn &fn) {
+  if (first >= last) {
+    return;
+  }
+  detail::ParallelForRange(pool, first, last,
+                           detail::AutoGrain(pool, first, last, grain), fn);
+}
+
+template <typename Index, typename Fn>
+void ParallelFor(Index first, Index last, Index grain, const Fn &fn) {
+  ParallelFor(GetDefaultThreadPool(), first, last, grain, fn);
+}
+
+/**
+ * 'reduce_range(begin, end)' folds one sub-range into a T, and 'combine'
+ * merges two partial results; it must be associative.
+ * @return 'identity' for an empty range
+ */
+template <typename T, typename Index, typename RangeFn, typename Combine>
+T ParallelReduce(ThreadPool &pool, Index first, Index last, Index grain,
+                 const T &identity, const RangeFn &reduce_range,
+                 const Combine &combine) {
+  if (first >= last) {
+    return identity;
+  }
+  return detail::ParallelReduceRange(
+      pool, first, last, detail::AutoGrain(pool, first, last, grain), identity,
+      reduce_range, combine);
+}
+
+template <typename T, typename Index, typename RangeFn, typename Combine>
+T ParallelReduce(Index first, Index last, Index grain, const T &identity,
+                 const RangeFn &reduce_range, const Combine &combine) {
+  return ParallelReduce(GetDefaultThreadPool(), first, last, grain, identity,
+                        reduce_range, combine);
+}
+
+/**
+ * Parallel std::transform over random access iterators.
+ * @return the end of the output range
+ */
+template <typename InputIt, typename OutputIt, typename UnaryOp>
+OutputIt ParallelTransform(ThreadPool &pool, InputIt first, InputIt last,
+                           OutputIt out, ptrdiff_t grain, const UnaryOp &op) {
+  ptrdiff_t count = last - first;
+  ParallelFor(pool, static_cast<ptrdiff_t>(0), count, grain,
+              [&](ptrdiff_t begin, ptrdiff_t end) {
+                std::transform(first + begin, first + end, out + begin, op);
+              });
+  return out + count;
+}
+
+template <typename InputIt, typename OutputIt, typename UnaryOp>
+OutputIt ParallelTransform(InputIt first, InputIt last, OutputIt out,
+                           ptrdiff_t grain, const UnaryOp &op) {
+  return ParallelTransform(GetDefaultThreadPool(), first, last, out, grain,
+                           op);
+}
+
+/**
+ * Merge sort: halves are sorted in parallel down to 'grain' elements with
+ * std::sort, then merged back. Not stable.
+ */
+template <typename RandomIt, typename Compare>
+void ParallelSort(ThreadPool &pool, RandomIt first, RandomIt last,
+                  const Compare &comp, ptrdiff_t grain = 0) {
+  ptrdiff_t count = last - first;
+  if (count < 2) {
+    return;
+  }
+  if (grain <= 0) {
+    // Sorting is cheap per element, keep chunks large
+    grain = std::max<ptrdiff_t>(
+        detail::AutoGrain<ptrdiff_t>(pool, 0, count, 0), 2048);
+  }
+  detail::ParallelMergeSort(pool, first, last, grain, comp);
+}
+
+template <typename RandomIt, typename Compare>
+void ParallelSort(RandomIt first, RandomIt last, const Compare &comp) {
+  ParallelSort(GetDefaultThreadPool(), first, last, comp);
+}
+
+template <typename RandomIt>
+void ParallelSort(RandomIt first, RandomIt last) {
+  ParallelSort(GetDefaultThreadPool(), first, last,
+               std::less<typename std::iterator_traits<RandomIt>::value_type>());
+}
+
+}  // namespace Utils
+
+#endif  // UTILS_PARALLEL_H_
@@ -0,0 +1,29 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Readiness callback for the thread safe containers.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#ifndef UTILS_QUEUE_NOTIFIER_H_
+#define UTILS_QUEUE_NOTIFIER_H_
+
+namespace Utils {
+
+/**
+ * Attached to a container to learn when it becomes readable. Notify() is
+ * called outside the container lock, on the empty to non-empty transition
+ * only, and once on Close(). It is edge triggered: after a notification the
+ * consumer must drain the container until it is empty, later pushes into a
+ * non-empty container do not notify again.
+ */
+class QueueNotifier {
+ public:
+  virtual ~QueueNotifier() = default;
+
+  virtual void Notify() = 0;
+};
+
+}  // namespace Utils
+
+#endif  // UTILS_QUEUE_NOTIFIER_H_
@@ -0,0 +1,141 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Block on several thread safe queues at once.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#ifndef UTILS_QUEUE_SET_H_
+#define UTILS_QUEUE_SET_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "queue_notifier.h"
+#include "queue_status.h"
+#include "thread_safe_queue.h"
+
+namespace Utils {
+
+/**
+ * Which ready member Select() reports when several have data.
+ */
+enum class SelectPolicy {
+  // The lowest index, i.e. the queue added first, always wins
+  kPriority = 0,
+  // Scan from the member after the last one reported, so a busy queue can
+  // not starve the others
+  kRoundRobin = 1
+};
+
+/**
+ * Lets a consumer wait until any of several ThreadSafeQueues has data:
+ *
+ *   QueueSet set;
+ *   size_t high = set.Add(high_queue);
+ *   set.Add(low_queue);
+ *   size_t index;
+ *   while (set.Select(index)) {
+ *     if (index == high) { high_queue.TryPop(job); } else { ... }
+ *   }
+ *
+ * Members are watched through their QueueNotifier, so a queue can belong to
+ * one set and have no other notifier. Queues outside any set keep a null
+ * notifier and pay nothing. Another consumer may empty a reported queue
+ * first, so the TryPop after Select() can fail.
+ */
+class QueueSet {
+ public:
+  explicit QueueSet(SelectPolicy policy = SelectPolicy::kPriority);
+
+  /**
+   * Detaches from every member, waiting for notifications already in flight,
+   * so pushes may race with the destruction. Members must outlive the set.
+   */
+  ~QueueSet();
+
+  QueueSet(const QueueSet &other) = delete;
+  QueueSet &operator=(const QueueSet &other) = delete;
+
+  /**
+   * @return the index Select() reports for 'queue'
+   */
+  template <typename T, typename Storage, typename Telemetry>
+  size_t Add(ThreadSafeQueue<T, Storage, Telemetry> &queue);
+
+  /**
+   * Block until a member has data.
+   * @return false once every member is closed and drained
+   */
+  bool Select(size_t &index);
+
+  template <typename Rep, typename Period>
+  QueueStatus SelectFor(size_t &index,
+                        const std::chrono::duration<Rep, Period> &timeout) {
+    return SelectUntil(
+        index, std::chrono::steady_clock::now() +
+                   std::chrono::duration_cast<
+                       std::chrono::steady_clock::duration>(timeout));
+  }
+
+  QueueStatus SelectUntil(size_t &index,
+                          const std::chrono::steady_clock::time_point &deadline);
+
+  /**
+   * @return the first ready member without blocking, false if none
+   */
+  bool TrySelect(size_t &index);
+
+  size_t Size() const;
+
+ private:
+  struct Member : public QueueNotifier {
+    void Notify() override { set->Signal(); }
+
+    QueueSet *set{nullptr};
+    std::function<bool()> has_data;
+    std::function<bool()> is_closed;
+    std::function<void()> detach;
+  };
+
+  void Signal();
+
+  // Scan members per policy under 'mut_', kClosed if all are drained
+  QueueStatus Scan(size_t &index);
+
+  QueueStatus Wait(size_t &index,
+                   const std::chrono::steady_clock::time_point *deadline);
+
+  const SelectPolicy policy_;
+  mutable std::mutex mut_;
+  std::condition_variable cond_;
+  std::vector<std::unique_ptr<Member> > members_;
+  size_t next_{0};
+  uint64_t signals_{0};
+};  // class QueueSet
+
+template <typename T, typename Storage, typename Telemetry>
+size_t QueueSet::Add(ThreadSafeQueue<T, Storage, Telemetry> &queue) {
+  std::unique_ptr<Member> member(new Member());
+  member->set = this;
+  member->has_data = [&queue] { return !queue.IsEmpty(); };
+  member->is_closed = [&queue] { return queue.IsClosed(); };
+  member->detach = [&queue] { queue.SetNotifier(nullptr); };
+  queue.SetNotifier(member.get());
+
+  std::lock_guard<std::mutex> lk(mut_);
+  members_.push_back(std::move(member));
+  signals_++;
+  cond_.notify_all();
+  return members_.size() - 1;
+}
+
+}  // namespace Utils
+
+#endif  // UTILS_QUEUE_SET_H_
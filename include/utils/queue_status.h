@@ -0,0 +1,51 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Result codes and policies shared by the blocking containers.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#ifndef UTILS_QUEUE_STATUS_H_
+#define UTILS_QUEUE_STATUS_H_
+
+namespace Utils {
+
+enum class QueueStatus {
+  kSuccess = 0,
+  // No element arrived before the deadline
+  kTimeout = 1,
+  // The container was closed and is drained
+  kClosed = 2
+};
+
+/**
+ * What a bounded container does with a push while it is full.
+ */
+enum class OverflowPolicy {
+  // Wait for a consumer to free a slot
+  kBlock = 0,
+  // Fail the push, counted as rejected
+  kReject = 1,
+  // Discard the oldest element to make room
+  kDropOldest = 2,
+  // Discard the new value, counted as dropped
+  kDropNewest = 3
+};
+
+/**
+ * How a consumer waits for an element.
+ */
+enum class WaitStrategy {
+  // Sleep on the condition variable right away
+  kBlocking = 0,
+  // Spin with pause, then yield, then sleep. Timed waits use this for
+  // kBusySpin as well
+  kSpinThenPark = 1,
+  // Never sleep or yield, for the lowest handoff latency. Needs a core per
+  // spinning consumer, oversubscribed it is far slower than blocking
+  kBusySpin = 2
+};
+
+}  // namespace Utils
+
+#endif  // UTILS_QUEUE_STATUS_H_
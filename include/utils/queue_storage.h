@@ -0,0 +1,176 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Element storage policies for the thread safe containers.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#ifndef UTILS_QUEUE_STORAGE_H_
+#define UTILS_QUEUE_STORAGE_H_
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "chunked_ring.h"
+
+namespace Utils {
+
+/**
+ * Every element is held by a std::shared_ptr<T>. Pops that return a
+ * shared_ptr hand out the stored pointer without copying, and Front()/Back()
+ * alias the element still in the container.
+ */
+struct SharedPtrStorage {};
+
+/**
+ * Elements are held by value in a ChunkedRing. Pushing an rvalue and popping
+ * into a T& only move the element and allocate nothing in steady state. The
+ * shared_ptr returning calls are kept for compatibility: they move the
+ * element into a new shared_ptr, and Front()/Back() return a copy.
+ */
+struct ValueStorage {};
+
+template <typename T, typename Storage>
+class ElementStore;
+
+template <typename T>
+class ElementStore<T, SharedPtrStorage> {
+ public:
+  typedef std::shared_ptr<T> Element;
+
+  // Called outside the container lock, so the allocation is not serialized
+  template <typename... Args>
+  static Element MakeElement(Args&&... args) {
+    return std::make_shared<T>(std::forward<Args>(args)...);
+  }
+
+  void PushBack(Element&& element) { items_.push_back(std::move(element)); }
+
+  void PushFront(Element&& element) { items_.push_front(std::move(element)); }
+
+  void PopFront(T& value) {
+    value = std::move(*items_.front());
+    items_.pop_front();
+  }
+
+  void PopBack(T& value) {
+    value = std::move(*items_.back());
+    items_.pop_back();
+  }
+
+  std::shared_ptr<T> PopFrontShared() {
+    std::shared_ptr<T> res = std::move(items_.front());
+    items_.pop_front();
+    return res;
+  }
+
+  std::shared_ptr<T> PopBackShared() {
+    std::shared_ptr<T> res = std::move(items_.back());
+    items_.pop_back();
+    return res;
+  }
+
+  void DropFront() { items_.pop_front(); }
+
+  void PopFrontTo(std::vector<T>& out) {
+    out.push_back(std::move(*items_.front()));
+    items_.pop_front();
+  }
+
+  void PopBackTo(std::vector<T>& out) {
+    out.push_back(std::move(*items_.back()));
+    items_.pop_back();
+  }
+
+  std::shared_ptr<T> FrontShared() const { return items_.front(); }
+
+  std::shared_ptr<T> BackShared() const { return items_.back(); }
+
+  bool Empty() const { return items_.empty(); }
+
+  size_t Size() const { return items_.size(); }
+
+  void Clear() { std::deque<Element>().swap(items_); }
+
+  void Swap(ElementStore& other) { items_.swap(other.items_); }
+
+ private:
+  std::deque<Element> items_;
+};
+
+template <typename T>
+class ElementStore<T, ValueStorage> {
+ public:
+  typedef T Element;
+
+  template <typename... Args>
+  static Element MakeElement(Args&&... args) {
+    return T(std::forward<Args>(args)...);
+  }
+
+  void PushBack(Element&& element) { items_.EmplaceBack(std::move(element)); }
+
+  void PushFront(Element&& element) {
+    items_.EmplaceFront(std::move(element));
+  }
+
+  void PopFront(T& value) {
+    value = std::move(items_.Front());
+    items_.PopFront();
+  }
+
+  void PopBack(T& value) {
+    value = std::move(items_.Back());
+    items_.PopBack();
+  }
+
+  std::shared_ptr<T> PopFrontShared() {
+    auto res = std::make_shared<T>(std::move(items_.Front()));
+    items_.PopFront();
+    return res;
+  }
+
+  std::shared_ptr<T> PopBackShared() {
+    auto res = std::make_shared<T>(std::move(items_.Back()));
+    items_.PopBack();
+    return res;
+  }
+
+  void DropFront() { items_.PopFront(); }
+
+  void PopFrontTo(std::vector<T>& out) {
+    out.push_back(std::move(items_.Front()));
+    items_.PopFront();
+  }
+
+  void PopBackTo(std::vector<T>& out) {
+    out.push_back(std::move(items_.Back()));
+    items_.PopBack();
+  }
+
+  std::shared_ptr<T> FrontShared() const {
+    return std::make_shared<T>(items_[0]);
+  }
+
+  std::shared_ptr<T> BackShared() const {
+    return std::make_shared<T>(items_[items_.Size() - 1]);
+  }
+
+  bool Empty() const { return items_.Empty(); }
+
+  size_t Size() const { return items_.Size(); }
+
+  void Clear() { ChunkedRing<T>().Swap(items_); }
+
+  void Swap(ElementStore& other) { items_.Swap(other.items_); }
+
+ private:
+  ChunkedRing<T> items_;
+};
+
+}  // namespace Utils
+
+#endif  // UTILS_QUEUE_STORAGE_H_
@@ -0,0 +1,186 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Opt-in instrumentation policies for ThreadSafeQueue.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#ifndef UTILS_QUEUE_TELEMETRY_H_
+#define UTILS_QUEUE_TELEMETRY_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "chunked_ring.h"
+
+namespace Utils {
+
+/**
+ * Point in time view of a queue's telemetry. Rates are averaged over
+ * 'elapsed_seconds', the lifetime of the queue. Histogram bucket 0 counts
+ * values below 1, bucket i counts values in [2^(i-1), 2^i), the last bucket
+ * everything above.
+ */
+struct QueueTelemetrySnapshot {
+  bool enabled{false};
+  double elapsed_seconds{0};
+
+  uint64_t enqueued{0};
+  uint64_t dequeued{0};
+  // Dropped by an overflow policy or removed by Clear()
+  uint64_t discarded{0};
+  double enqueue_rate{0};
+  double dequeue_rate{0};
+
+  size_t depth{0};
+  size_t max_depth{0};
+  // Depth seen by every push, in elements
+  std::vector<uint64_t> depth_histogram;
+
+  // Time from push to pop, in microseconds
+  uint64_t sojourn_count{0};
+  double sojourn_mean_us{0};
+  double sojourn_max_us{0};
+  std::vector<uint64_t> sojourn_histogram_us;
+
+  // Time consumers spent in blocking pops, spinning included
+  uint64_t consumer_waits{0};
+  double consumer_wait_mean_us{0};
+  double consumer_wait_max_us{0};
+};
+
+/**
+ * @param indent as nlohmann::json::dump, -1 for a compact single line
+ */
+std::string TelemetryToJson(const QueueTelemetrySnapshot &snapshot,
+                            int indent = -1);
+
+/**
+ * Default policy, every hook is empty and inlined away.
+ */
+struct NullTelemetry {
+  static int64_t Now() { return 0; }
+
+  void OnPush(size_t /*count*/, size_t /*depth*/) {}
+
+  void OnPop(size_t /*count*/, size_t /*depth*/) {}
+
+  void OnDiscard(size_t /*count*/, size_t /*depth*/) {}
+
+  void OnConsumerWait(int64_t /*start*/) {}
+
+  QueueTelemetrySnapshot Snapshot(size_t depth) const {
+    QueueTelemetrySnapshot snapshot;
+    snapshot.depth = depth;
+    return snapshot;
+  }
+};
+
+/**
+ * Records counters, depth, sojourn and wait time. Every push is timestamped
+ * in a FIFO next to the elements, so the policy fits queues that pop from the
+ * front only. The hooks are called under the queue lock and cost a clock read
+ * per push and pop.
+ */
+class QueueTelemetry {
+ public:
+  static const size_t kBuckets = 24;
+
+  QueueTelemetry();
+
+  static int64_t Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  void OnPush(size_t count, size_t depth);
+
+  void OnPop(size_t count, size_t depth);
+
+  void OnDiscard(size_t count, size_t depth);
+
+  void OnConsumerWait(int64_t start);
+
+  QueueTelemetrySnapshot Snapshot(size_t depth) const;
+
+ private:
+  static size_t Bucket(uint64_t value);
+
+  int64_t created_at_;
+  ChunkedRing<int64_t> push_times_;
+
+  uint64_t enqueued_{0};
+  uint64_t dequeued_{0};
+  uint64_t discarded_{0};
+  size_t max_depth_{0};
+  uint64_t depth_histogram_[kBuckets];
+
+  uint64_t sojourn_count_{0};
+  int64_t sojourn_total_ns_{0};
+  int64_t sojourn_max_ns_{0};
+  uint64_t sojourn_histogram_[kBuckets];
+
+  uint64_t consumer_waits_{0};
+  int64_t consumer_wait_total_ns_{0};
+  int64_t consumer_wait_max_ns_{0};
+};  // class QueueTelemetry
+
+inline size_t QueueTelemetry::Bucket(uint64_t value) {
+  size_t bucket = 0;
+  while (value > 0 && bucket < kBuckets - 1) {
+    value >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+inline void QueueTelemetry::OnPush(size_t count, size_t depth) {
+  int64_t now = Now();
+  for (size_t i = 0; i < count; i++) {
+    push_times_.EmplaceBack(now);
+  }
+  enqueued_ += count;
+  if (depth > max_depth_) {
+    max_depth_ = depth;
+  }
+  depth_histogram_[Bucket(depth)]++;
+}
+
+inline void QueueTelemetry::OnPop(size_t count, size_t /*depth*/) {
+  int64_t now = Now();
+  for (size_t i = 0; i < count && !push_times_.Empty(); i++) {
+    int64_t sojourn = now - push_times_.Front();
+    push_times_.PopFront();
+    sojourn_count_++;
+    sojourn_total_ns_ += sojourn;
+    if (sojourn > sojourn_max_ns_) {
+      sojourn_max_ns_ = sojourn;
+    }
+    sojourn_histogram_[Bucket(static_cast<uint64_t>(sojourn / 1000))]++;
+  }
+  dequeued_ += count;
+}
+
+inline void QueueTelemetry::OnDiscard(size_t count, size_t /*depth*/) {
+  for (size_t i = 0; i < count && !push_times_.Empty(); i++) {
+    push_times_.PopFront();
+  }
+  discarded_ += count;
+}
+
+inline void QueueTelemetry::OnConsumerWait(int64_t start) {
+  int64_t wait = Now() - start;
+  consumer_waits_++;
+  consumer_wait_total_ns_ += wait;
+  if (wait > consumer_wait_max_ns_) {
+    consumer_wait_max_ns_ = wait;
+  }
+}
+
+}  // namespace Utils
+
+#endif  // UTILS_QUEUE_TELEMETRY_H_
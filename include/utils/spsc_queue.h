@@ -0,0 +1,275 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Wait-free single-producer single-consumer ring queue.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#ifndef UTILS_SPSC_QUEUE_H_
+#define UTILS_SPSC_QUEUE_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "lock_free_common.h"
+
+namespace Utils {
+
+/**
+ * Ring buffer for exactly one producer thread and one consumer thread.
+ *
+ * Producer and consumer state live on separate cache lines, and each side
+ * keeps a cached copy of the other side's index, so the shared index is only
+ * re-read when the ring looks full (producer) or empty (consumer). TryPush and
+ * TryPop are wait-free.
+ *
+ * With 'blocking' set, WaitAndPop parks the consumer on a condition variable
+ * after a short spin, and the producer signals it only when the consumer is
+ * actually asleep. This costs the producer one fence per push, so it is off
+ * by default and WaitAndPop then spins and yields.
+ */
+template <typename T>
+class SpscQueue {
+ public:
+  explicit SpscQueue(size_t capacity, bool blocking = false);
+
+  ~SpscQueue();
+
+  SpscQueue(const SpscQueue& other) = delete;
+  SpscQueue& operator=(const SpscQueue& other) = delete;
+
+  bool TryPush(const T& new_value) { return TryEmplace(new_value); }
+
+  bool TryPush(T&& new_value) { return TryEmplace(std::move(new_value)); }
+
+  template <typename... Args>
+  bool TryEmplace(Args&&... args);
+
+  /**
+   * Copy up to 'count' items with a single publication.
+   * @return number of items pushed
+   */
+  size_t TryPushBulk(const T* items, size_t count);
+
+  bool TryPop(T& value);
+
+  /**
+   * Move up to 'max_count' items into 'items' with a single release.
+   * @return number of items popped
+   */
+  size_t TryPopBulk(T* items, size_t max_count);
+
+  /**
+   * Spin, then yield, until there is room for the new value.
+   */
+  void Push(const T& new_value);
+
+  void Push(T&& new_value);
+
+  void WaitAndPop(T& value);
+
+  /**
+   * Approximate when called from neither the producer nor the consumer.
+   */
+  size_t Size() const;
+
+  bool IsEmpty() const { return Size() == 0; }
+
+  size_t Capacity() const { return mask_ + 1; }
+
+ private:
+  T* Slot(size_t index) {
+    return reinterpret_cast<T*>(&buffer_[index & mask_]);
+  }
+
+  void NotifyConsumer();
+
+  typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type Storage;
+
+  Storage* const buffer_;
+  const size_t mask_;
+  const bool blocking_;
+
+  // Producer side
+  char padding0_[kCacheLineSize];
+  std::atomic<size_t> tail_{0};
+  size_t cached_head_{0};
+  char padding1_[kCacheLineSize - sizeof(std::atomic<size_t>) -
+                 sizeof(size_t)];
+
+  // Consumer side
+  std::atomic<size_t> head_{0};
+  size_t cached_tail_{0};
+  char padding2_[kCacheLineSize - sizeof(std::atomic<size_t>) -
+                 sizeof(size_t)];
+
+  // Only used in blocking mode
+  std::atomic<bool> consumer_waiting_{false};
+  std::mutex wait_mutex_;
+  std::condition_variable wait_cond_;
+};
+
+template <typename T>
+SpscQueue<T>::SpscQueue(size_t capacity, bool blocking)
+    : buffer_(new Storage[RoundUpPowerOfTwo(capacity)]),
+      mask_(RoundUpPowerOfTwo(capacity) - 1),
+      blocking_(blocking) {}
+
+template <typename T>
+SpscQueue<T>::~SpscQueue() {
+  size_t tail = tail_.load(std::memory_order_relaxed);
+  for (size_t pos = head_.load(std::memory_order_relaxed); pos != tail;
+       pos++) {
+    Slot(pos)->~T();
+  }
+  delete[] buffer_;
+}
+
+template <typename T>
+template <typename... Args>
+inline bool SpscQueue<T>::TryEmplace(Args&&... args) {
+  size_t tail = tail_.load(std::memory_order_relaxed);
+  if (tail - cached_head_ > mask_) {
+    cached_head_ = head_.load(std::memory_order_acquire);
+    if (tail - cached_head_ > mask_) {
+      return false;
+    }
+  }
+  new (Slot(tail)) T(std::forward<Args>(args)...);
+  tail_.store(tail + 1, std::memory_order_release);
+  if (blocking_) {
+    NotifyConsumer();
+  }
+  return true;
+}
+
+template <typename T>
+size_t SpscQueue<T>::TryPushBulk(const T* items, size_t count) {
+  size_t tail = tail_.load(std::memory_order_relaxed);
+  size_t free_slots = mask_ + 1 - (tail - cached_head_);
+  if (free_slots < count) {
+    cached_head_ = head_.load(std::memory_order_acquire);
+    free_slots = mask_ + 1 - (tail - cached_head_);
+  }
+  if (count > free_slots) {
+    count = free_slots;
+  }
+  if (count == 0) {
+    return 0;
+  }
+  for (size_t i = 0; i < count; i++) {
+    new (Slot(tail + i)) T(items[i]);
+  }
+  tail_.store(tail + count, std::memory_order_release);
+  if (blocking_) {
+    NotifyConsumer();
+  }
+  return count;
+}
+
+template <typename T>
+inline bool SpscQueue<T>::TryPop(T& value) {
+  size_t head = head_.load(std::memory_order_relaxed);
+  if (head == cached_tail_) {
+    cached_tail_ = tail_.load(std::memory_order_acquire);
+    if (head == cached_tail_) {
+      return false;
+    }
+  }
+  T* item = Slot(head);
+  value = std::move(*item);
+  item->~T();
+  head_.store(head + 1, std::memory_order_release);
+  return true;
+}
+
+template <typename T>
+size_t SpscQueue<T>::TryPopBulk(T* items, size_t max_count) {
+  size_t head = head_.load(std::memory_order_relaxed);
+  size_t available = cached_tail_ - head;
+  if (available < max_count) {
+    cached_tail_ = tail_.load(std::memory_order_acquire);
+    available = cached_tail_ - head;
+  }
+  if (max_count > available) {
+    max_count = available;
+  }
+  for (size_t i = 0; i < max_count; i++) {
+    T* item = Slot(head + i);
+    items[i] = std::move(*item);
+    item->~T();
+  }
+  if (max_count > 0) {
+    head_.store(head + max_count, std::memory_order_release);
+  }
+  return max_count;
+}
+
+template <typename T>
+void SpscQueue<T>::Push(const T& new_value) {
+  Backoff backoff;
+  while (!TryEmplace(new_value)) {
+    backoff.Pause();
+  }
+}
+
+template <typename T>
+void SpscQueue<T>::Push(T&& new_value) {
+  Backoff backoff;
+  // TryEmplace only moves from 'new_value' once a slot is free
+  while (!TryEmplace(std::move(new_value))) {
+    backoff.Pause();
+  }
+}
+
+template <typename T>
+void SpscQueue<T>::WaitAndPop(T& value) {
+  Backoff backoff;
+  for (int i = 0; i < 16; i++) {
+    if (TryPop(value)) {
+      return;
+    }
+    backoff.Pause();
+  }
+  if (!blocking_) {
+    while (!TryPop(value)) {
+      backoff.Pause();
+    }
+    return;
+  }
+
+  std::unique_lock<std::mutex> lk(wait_mutex_);
+  consumer_waiting_.store(true, std::memory_order_relaxed);
+  // Pairs with the fence in NotifyConsumer: either the producer sees the
+  // flag, or TryPop below sees the new tail.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  while (!TryPop(value)) {
+    wait_cond_.wait(lk);
+  }
+  consumer_waiting_.store(false, std::memory_order_relaxed);
+}
+
+template <typename T>
+inline void SpscQueue<T>::NotifyConsumer() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (consumer_waiting_.load(std::memory_order_relaxed)) {
+    std::lock_guard<std::mutex> lk(wait_mutex_);
+    wait_cond_.notify_one();
+  }
+}
+
+template <typename T>
+size_t SpscQueue<T>::Size() const {
+  size_t tail = tail_.load(std::memory_order_acquire);
+  size_t head = head_.load(std::memory_order_acquire);
+  return tail > head ? tail - head : 0;
+}
+
+}  // namespace Utils
+
+#endif  // UTILS_SPSC_QUEUE_H_
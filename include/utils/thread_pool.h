@@ -0,0 +1,192 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Work stealing thread pool.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#ifndef UTILS_THREAD_POOL_H_
+#define UTILS_THREAD_POOL_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "thread_safe_queue.h"
+#include "work_stealing_deque.h"
+
+namespace Utils {
+
+/**
+ * Fixed size pool where every worker owns a WorkStealingDeque. A task posted
+ * from inside a worker goes to that worker's deque without taking a lock and
+ * is popped LIFO, which keeps fork-join recursion cache warm. Tasks posted
+ * from other threads go through a shared injection queue. An idle worker
+ * takes from its own deque, then the injection queue, then steals from the
+ * other workers, and only sleeps after a short spin.
+ *
+ * Shutdown() is graceful: it rejects new external tasks, runs everything
+ * already queued, including tasks those tasks post, then joins the workers.
+ */
+class ThreadPool {
+ public:
+  typedef std::function<void()> Task;
+
+  /**
+   * @param thread_count number of workers, zero means one per hardware thread
+   */
+  explicit ThreadPool(size_t thread_count = 0);
+
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &other) = delete;
+  ThreadPool &operator=(const ThreadPool &other) = delete;
+
+  /**
+   * Run 'f(args...)' on the pool. Exceptions are stored in the future.
+   * @return the result future, invalid if the pool is shut down
+   */
+  template <typename F, typename... Args>
+  std::future<typename std::result_of<F(Args...)>::type> Submit(
+      F &&f, Args &&... args);
+
+  /**
+   * Fire and forget, cheaper than Submit. The task must not throw.
+   * @return false if the pool is shut down
+   */
+  bool Post(Task task);
+
+  /**
+   * Post [first, last) of Task with one enqueue and one wake-up.
+   * @return false if the pool is shut down
+   */
+  template <typename InputIt>
+  bool PostBatch(InputIt first, InputIt last);
+
+  /**
+   * Wait until 'future' is ready. A worker of this pool keeps running tasks
+   * from its own deque meanwhile, which are the children it posted, so
+   * fork-join recursion can not run out of threads and the nesting stays as
+   * deep as the recursion. Any other thread simply blocks.
+   */
+  template <typename R>
+  void Await(const std::future<R> &future);
+
+  /**
+   * Run at most one queued task on the calling thread.
+   * @return false if no task was found
+   */
+  bool RunPendingTask();
+
+  void Shutdown();
+
+  size_t GetThreadCount() const { return workers_.size(); }
+
+  /**
+   * Tasks queued and not started yet, approximate.
+   */
+  size_t GetPendingCount() const;
+
+  /**
+   * @return the index of the calling worker in this pool, -1 if the caller is
+   * not one of its workers
+   */
+  int CurrentWorkerIndex() const;
+
+ private:
+  struct TaskNode {
+    explicit TaskNode(Task &&t) : task(std::move(t)) {}
+    Task task;
+  };
+
+  struct Worker {
+    WorkStealingDeque<TaskNode *> deque;
+    std::thread thread;
+  };
+
+  static const int kSpinRounds = 16;
+
+  // Takes ownership of 'nodes', freed if the pool is shut down
+  bool Enqueue(std::vector<TaskNode *> &nodes);
+
+  TaskNode *FindTask(int index);
+
+  TaskNode *Steal(int index);
+
+  bool RunLocalTask(int index);
+
+  void RunTask(TaskNode *node);
+
+  void WorkerLoop(int index);
+
+  // Sleep until there is work, false once the pool stopped and is drained
+  bool WaitForWork();
+
+  void WakeWorkers(size_t count);
+
+  std::vector<std::unique_ptr<Worker> > workers_;
+  ThreadSafeQueue<TaskNode *, ValueStorage> injected_;
+
+  // Queued tasks, raised before a task becomes visible
+  std::atomic<int64_t> pending_{0};
+
+  std::mutex sleep_mutex_;
+  std::condition_variable sleep_cond_;
+  std::atomic<int> sleepers_{0};
+  std::atomic<bool> stopping_{false};
+
+  std::mutex shutdown_mutex_;
+};  // class ThreadPool
+
+template <typename F, typename... Args>
+std::future<typename std::result_of<F(Args...)>::type> ThreadPool::Submit(
+    F &&f, Args &&... args) {
+  typedef typename std::result_of<F(Args...)>::type R;
+  auto task = std::make_shared<std::packaged_task<R()> >(
+      std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+  std::future<R> res = task->get_future();
+  if (!Post([task] { (*task)(); })) {
+    return std::future<R>();
+  }
+  return res;
+}
+
+template <typename InputIt>
+bool ThreadPool::PostBatch(InputIt first, InputIt last) {
+  std::vector<TaskNode *> nodes;
+  for (; first != last; ++first) {
+    nodes.push_back(new TaskNode(Task(*first)));
+  }
+  if (nodes.empty()) {
+    return !stopping_.load(std::memory_order_acquire);
+  }
+  return Enqueue(nodes);
+}
+
+template <typename R>
+void ThreadPool::Await(const std::future<R> &future) {
+  int index = CurrentWorkerIndex();
+  while (future.wait_for(std::chrono::seconds(0)) !=
+         std::future_status::ready) {
+    // Only this worker pushes to its deque, once it is empty the awaited
+    // task was stolen and runs elsewhere
+    if (index < 0 || !RunLocalTask(index)) {
+      future.wait();
+      return;
+    }
+  }
+}
+
+}  // namespace Utils
+
+#endif  // UTILS_THREAD_POOL_H_
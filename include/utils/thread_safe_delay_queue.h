@@ -0,0 +1,350 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Thread safe queue whose elements become poppable at a due time.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#ifndef UTILS_THREAD_SAFE_DELAY_QUEUE_H_
+#define UTILS_THREAD_SAFE_DELAY_QUEUE_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "dary_heap.h"
+#include "queue_status.h"
+
+namespace Utils {
+
+/**
+ * Elements are pushed with a delay and handed out in due order once the
+ * steady clock reaches their due time, FIFO among equal due times:
+ *
+ *   queue.Push(request, std::chrono::milliseconds(200));
+ *   ...
+ *   while (queue.WaitAndPop(request)) { Retry(request); }
+ *
+ * Consumers follow a leader/follower scheme: one consumer sleeps until the
+ * earliest due time, the others sleep without a deadline until the leader
+ * hands over. A push only wakes anyone if it becomes the new earliest
+ * element, so no consumer wakes before there is something due.
+ *
+ * Close() rejects further pushes; the elements left are handed out without
+ * waiting for their due time, so consumers can drain and exit.
+ */
+template <typename T>
+class ThreadSafeDelayQueue {
+ public:
+  typedef std::chrono::steady_clock Clock;
+  typedef Clock::time_point TimePoint;
+
+  ThreadSafeDelayQueue() = default;
+
+  ThreadSafeDelayQueue(const ThreadSafeDelayQueue& other) = delete;
+  ThreadSafeDelayQueue& operator=(const ThreadSafeDelayQueue& other) = delete;
+
+  /**
+   * @return false if the queue is closed, the value is dropped then
+   */
+  template <typename Rep, typename Period>
+  bool Push(const T& new_value,
+            const std::chrono::duration<Rep, Period>& delay) {
+    return PushAt(new_value, Clock::now() + ToClock(delay));
+  }
+
+  template <typename Rep, typename Period>
+  bool Push(T&& new_value, const std::chrono::duration<Rep, Period>& delay) {
+    return PushAt(std::move(new_value), Clock::now() + ToClock(delay));
+  }
+
+  bool PushAt(const T& new_value, TimePoint due) {
+    return PushEntry(new_value, due);
+  }
+
+  bool PushAt(T&& new_value, TimePoint due) {
+    return PushEntry(std::move(new_value), due);
+  }
+
+  /**
+   * Block until the earliest element is due and pop it.
+   * @return false if the queue was closed and is drained
+   */
+  bool WaitAndPop(T& value);
+
+  template <typename Rep, typename Period>
+  QueueStatus WaitAndPopFor(T& value,
+                            const std::chrono::duration<Rep, Period>& timeout) {
+    return WaitAndPopUntil(value, Clock::now() + ToClock(timeout));
+  }
+
+  QueueStatus WaitAndPopUntil(T& value, TimePoint deadline);
+
+  /**
+   * @return false if no element is due yet
+   */
+  bool TryPop(T& value);
+
+  /**
+   * Move every due element to the end of 'out' without blocking.
+   * @return number of elements popped
+   */
+  size_t PopAllDue(std::vector<T>& out);
+
+  /**
+   * Block until an element is due, then move every due element to the end
+   * of 'out'.
+   * @return number of elements popped, zero once closed and drained
+   */
+  size_t WaitAndPopAllDue(std::vector<T>& out);
+
+  /**
+   * @return false if empty, otherwise 'due' is set to the earliest due time
+   */
+  bool GetNextDue(TimePoint& due) const;
+
+  /**
+   * Reject further pushes and wake every waiter.
+   */
+  void Close();
+
+  bool IsClosed() const;
+
+  bool IsEmpty() const;
+
+  void Clear();
+
+  /**
+   * @return number of pending elements, due or not
+   */
+  size_t Size() const;
+
+ private:
+  struct Entry {
+    TimePoint due;
+    // Push order, keeps equal due times FIFO
+    uint64_t seq;
+    T value;
+  };
+
+  // Puts the earliest due time on top of the heap
+  struct EntryLater {
+    bool operator()(const Entry& a, const Entry& b) const {
+      return a.due > b.due || (a.due == b.due && a.seq > b.seq);
+    }
+  };
+
+  template <typename Rep, typename Period>
+  static Clock::duration ToClock(
+      const std::chrono::duration<Rep, Period>& duration) {
+    return std::chrono::duration_cast<Clock::duration>(duration);
+  }
+
+  template <typename U>
+  bool PushEntry(U&& new_value, TimePoint due);
+
+  bool HasDue() const {
+    return !heap_.Empty() && (closed_ || Clock::now() >= heap_.Top().due);
+  }
+
+  // Wait until an element is due, kClosed once closed and drained
+  QueueStatus WaitForDue(std::unique_lock<std::mutex>& lk,
+                         const TimePoint* deadline);
+
+  // Pop the top under the lock and pass leadership on if needed
+  void PopLocked(T& value);
+
+  size_t PopAllDueLocked(std::vector<T>& out);
+
+  // Wake a follower to lead when nobody sleeps until the next due time
+  void HandOver() {
+    if (!heap_.Empty() && waiters_ > 0 && leader_ == std::thread::id()) {
+      cond_.notify_one();
+    }
+  }
+
+  mutable std::mutex mut_;
+  DaryHeap<Entry, EntryLater> heap_;
+  std::condition_variable cond_;
+  bool closed_{false};
+  uint64_t next_seq_{0};
+  // Consumers asleep on 'cond_'
+  int waiters_{0};
+  // The consumer sleeping until the top is due, none while default
+  std::thread::id leader_;
+};
+
+template <typename T>
+template <typename U>
+bool ThreadSafeDelayQueue<T>::PushEntry(U&& new_value, TimePoint due) {
+  std::unique_lock<std::mutex> lk(mut_);
+  if (closed_) {
+    return false;
+  }
+  Entry entry = {due, next_seq_++, std::forward<U>(new_value)};
+  bool on_top = heap_.Push(std::move(entry));
+  // A later element leaves the leader's deadline valid
+  if (!on_top || waiters_ == 0) {
+    return true;
+  }
+  leader_ = std::thread::id();
+  lk.unlock();
+  cond_.notify_one();
+  return true;
+}
+
+template <typename T>
+QueueStatus ThreadSafeDelayQueue<T>::WaitForDue(
+    std::unique_lock<std::mutex>& lk, const TimePoint* deadline) {
+  while (true) {
+    if (HasDue()) {
+      return QueueStatus::kSuccess;
+    }
+    if (heap_.Empty() && closed_) {
+      return QueueStatus::kClosed;
+    }
+    if (deadline && Clock::now() >= *deadline) {
+      HandOver();
+      return QueueStatus::kTimeout;
+    }
+
+    waiters_++;
+    if (heap_.Empty() || leader_ != std::thread::id()) {
+      if (deadline) {
+        cond_.wait_until(lk, *deadline);
+      } else {
+        cond_.wait(lk);
+      }
+    } else {
+      std::thread::id self = std::this_thread::get_id();
+      leader_ = self;
+      TimePoint wake = heap_.Top().due;
+      if (deadline && *deadline < wake) {
+        wake = *deadline;
+      }
+      cond_.wait_until(lk, wake);
+      // A push of an earlier element may have replaced this leader
+      if (leader_ == self) {
+        leader_ = std::thread::id();
+      }
+    }
+    waiters_--;
+  }
+}
+
+template <typename T>
+void ThreadSafeDelayQueue<T>::PopLocked(T& value) {
+  value = std::move(heap_.PopTop().value);
+  HandOver();
+}
+
+template <typename T>
+bool ThreadSafeDelayQueue<T>::WaitAndPop(T& value) {
+  std::unique_lock<std::mutex> lk(mut_);
+  if (WaitForDue(lk, nullptr) != QueueStatus::kSuccess) {
+    return false;
+  }
+  PopLocked(value);
+  return true;
+}
+
+template <typename T>
+QueueStatus ThreadSafeDelayQueue<T>::WaitAndPopUntil(T& value,
+                                                     TimePoint deadline) {
+  std::unique_lock<std::mutex> lk(mut_);
+  QueueStatus status = WaitForDue(lk, &deadline);
+  if (status == QueueStatus::kSuccess) {
+    PopLocked(value);
+  }
+  return status;
+}
+
+template <typename T>
+bool ThreadSafeDelayQueue<T>::TryPop(T& value) {
+  std::lock_guard<std::mutex> lk(mut_);
+  if (!HasDue()) {
+    return false;
+  }
+  PopLocked(value);
+  return true;
+}
+
+template <typename T>
+size_t ThreadSafeDelayQueue<T>::PopAllDue(std::vector<T>& out) {
+  std::lock_guard<std::mutex> lk(mut_);
+  return PopAllDueLocked(out);
+}
+
+template <typename T>
+size_t ThreadSafeDelayQueue<T>::WaitAndPopAllDue(std::vector<T>& out) {
+  std::unique_lock<std::mutex> lk(mut_);
+  if (WaitForDue(lk, nullptr) != QueueStatus::kSuccess) {
+    return 0;
+  }
+  return PopAllDueLocked(out);
+}
+
+template <typename T>
+size_t ThreadSafeDelayQueue<T>::PopAllDueLocked(std::vector<T>& out) {
+  size_t count = 0;
+  TimePoint now = Clock::now();
+  while (!heap_.Empty() && (closed_ || now >= heap_.Top().due)) {
+    out.push_back(std::move(heap_.PopTop().value));
+    count++;
+  }
+  if (count > 0) {
+    HandOver();
+  }
+  return count;
+}
+
+template <typename T>
+bool ThreadSafeDelayQueue<T>::GetNextDue(TimePoint& due) const {
+  std::lock_guard<std::mutex> lk(mut_);
+  if (heap_.Empty()) {
+    return false;
+  }
+  due = heap_.Top().due;
+  return true;
+}
+
+template <typename T>
+void ThreadSafeDelayQueue<T>::Close() {
+  {
+    std::lock_guard<std::mutex> lk(mut_);
+    closed_ = true;
+  }
+  cond_.notify_all();
+}
+
+template <typename T>
+bool ThreadSafeDelayQueue<T>::IsClosed() const {
+  std::lock_guard<std::mutex> lk(mut_);
+  return closed_;
+}
+
+template <typename T>
+bool ThreadSafeDelayQueue<T>::IsEmpty() const {
+  std::lock_guard<std::mutex> lk(mut_);
+  return heap_.Empty();
+}
+
+template <typename T>
+void ThreadSafeDelayQueue<T>::Clear() {
+  std::lock_guard<std::mutex> lk(mut_);
+  heap_.Clear();
+}
+
+template <typename T>
+size_t ThreadSafeDelayQueue<T>::Size() const {
+  std::lock_guard<std::mutex> lk(mut_);
+  return heap_.Size();
+}
+
+}  // namespace Utils
+
+#endif  // UTILS_THREAD_SAFE_DELAY_QUEUE_H_
@@ -8,58 +8,598 @@
 #ifndef UTILS_THREAD_SAFE_LIST_H_
 #define UTILS_THREAD_SAFE_LIST_H_
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
-#include <list>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <thread>
 #include <utility>
+#include <vector>
+
+#include "queue_status.h"
+#include "queue_storage.h"
 
 namespace Utils {
 
-template <typename T>
+/**
+ * Double ended list, pushed and popped at both ends in O(1).
+ *
+ * 'Storage' selects how elements are held, see queue_storage.h. The default
+ * SharedPtrStorage keeps the original behaviour of the shared_ptr returning
+ * calls. ValueStorage holds elements by value in pooled chunks, so a push
+ * costs no allocation in steady state and draining walks contiguous memory;
+ * it is preferred for movable payloads popped into a T&.
+ */
+template <typename T, typename Storage = SharedPtrStorage>
 class ThreadSafeList {
  public:
   ThreadSafeList() = default;
 
   ThreadSafeList(const ThreadSafeList& other);
 
-  void PushBack(const T& new_value);
+  /**
+   * @return false if the list is closed, the value is dropped then
+   */
+  bool PushBack(const T& new_value);
+
+  bool PushBack(T&& new_value);
+
+  bool PushFront(const T& new_value);
 
-  void PushFront(const T& new_value);
+  bool PushFront(T&& new_value);
 
-  void WaitAndPopFront(T& value);
+  /**
+   * Append [first, last) with one lock acquisition and one notification.
+   * @return false if the list is closed
+   */
+  template <typename InputIt>
+  bool PushBackRange(InputIt first, InputIt last);
 
+  /**
+   * Insert [first, last) before the current front, keeping its order.
+   * @return false if the list is closed
+   */
+  template <typename InputIt>
+  bool PushFrontRange(InputIt first, InputIt last);
+
+  /**
+   * Block until an element is available.
+   * @return false if the list was closed and is drained
+   */
+  bool WaitAndPopFront(T& value);
+
+  /**
+   * @return nullptr if the list was closed and is drained
+   */
   std::shared_ptr<T> WaitAndPopFront();
 
+  template <typename Rep, typename Period>
+  QueueStatus WaitAndPopFrontFor(
+      T& value, const std::chrono::duration<Rep, Period>& timeout);
+
+  template <typename Clock, typename Duration>
+  QueueStatus WaitAndPopFrontUntil(
+      T& value, const std::chrono::time_point<Clock, Duration>& deadline);
+
   bool TryPopFront(T& value);
 
   std::shared_ptr<T> TryPopFront();
 
-  void WaitAndPopBack(T& value);
+  bool WaitAndPopBack(T& value);
 
   std::shared_ptr<T> WaitAndPopBack();
 
+  template <typename Rep, typename Period>
+  QueueStatus WaitAndPopBackFor(
+      T& value, const std::chrono::duration<Rep, Period>& timeout);
+
+  template <typename Clock, typename Duration>
+  QueueStatus WaitAndPopBackUntil(
+      T& value, const std::chrono::time_point<Clock, Duration>& deadline);
+
   bool TryPopBack(T& value);
 
   std::shared_ptr<T> TryPopBack();
 
+  /**
+   * Move every element, front to back, to the end of 'out'. The list is
+   * swapped out under the lock and drained after releasing it.
+   * @return number of elements popped
+   */
+  size_t PopAll(std::vector<T>& out);
+
+  /**
+   * Move at most 'max_count' elements from the front to the end of 'out'.
+   * @return number of elements popped
+   */
+  size_t PopFrontUpTo(std::vector<T>& out, size_t max_count);
+
+  /**
+   * Move at most 'max_count' elements from the back, back first, to the end
+   * of 'out'.
+   * @return number of elements popped
+   */
+  size_t PopBackUpTo(std::vector<T>& out, size_t max_count);
+
+  /**
+   * Like PopFrontUpTo, but wait up to 'timeout' for the first element.
+   * @return number of elements popped, zero on timeout or once the list is
+   * closed and drained
+   */
+  template <typename Rep, typename Period>
+  size_t WaitAndPopFrontUpTo(std::vector<T>& out, size_t max_count,
+                             const std::chrono::duration<Rep, Period>& timeout);
+
+  template <typename Rep, typename Period>
+  size_t WaitAndPopBackUpTo(std::vector<T>& out, size_t max_count,
+                            const std::chrono::duration<Rep, Period>& timeout);
+
+  /**
+   * With ValueStorage these return a copy of the element.
+   */
   std::shared_ptr<T> Front();
 
   std::shared_ptr<T> Back();
 
-  bool IsEmpty() const;
+  /**
+   * Reject further pushes and wake every waiter. Elements already in the list
+   * can still be popped; blocking pops report closed once it is drained.
+   */
+  void Close();
+
+  bool IsClosed() const;
+
+  /**
+   * Lock-free, approximate while other threads push or pop. Use
+   * IsEmptyExact() when the answer must be consistent with the lock.
+   */
+  bool IsEmpty() const {
+    return size_hint_.load(std::memory_order_acquire) == 0;
+  }
+
+  bool IsEmptyExact() const;
 
   void Clear();
 
-  size_t Size() const;
+  /**
+   * Lock-free, approximate while other threads push or pop.
+   */
+  size_t Size() const { return size_hint_.load(std::memory_order_acquire); }
+
+  size_t SizeExact() const;
 
  private:
+  typedef ElementStore<T, Storage> Store;
+
+  bool PushElement(typename Store::Element&& element, bool front);
+
+  template <typename InputIt>
+  bool PushElements(InputIt first, InputIt last, bool front);
+
+  size_t PopFrontUpToLocked(std::vector<T>& out, size_t max_count);
+
+  size_t PopBackUpToLocked(std::vector<T>& out, size_t max_count);
+
+  // Wake up to 'count' sleeping consumers, after releasing 'lk'
+  void NotifyConsumers(std::unique_lock<std::mutex>& lk, size_t count);
+
+  void WaitForData(std::unique_lock<std::mutex>& lk);
+
+  bool HasDataOrClosed() const { return !data_list_.Empty() || closed_; }
+
+  // Called after every change of 'data_list_' under the lock
+  void PublishSize() {
+    size_hint_.store(data_list_.Size(), std::memory_order_release);
+  }
+
+  template <typename Clock, typename Duration>
+  QueueStatus WaitUntil(std::unique_lock<std::mutex>& lk,
+                        const std::chrono::time_point<Clock, Duration>& deadline);
+
   mutable std::mutex mut_;
-  std::list<std::shared_ptr<T>> data_list_;
+  Store data_list_;
   std::condition_variable data_cond_;
+  bool closed_{false};
+  // Consumers asleep on 'data_cond_', pushes skip the notify while zero
+  int waiting_consumers_{0};
+  // Mirrors data_list_.Size() for the lock-free Size() and IsEmpty()
+  std::atomic<size_t> size_hint_{0};
 };
 
+template <typename T, typename Storage>
+ThreadSafeList<T, Storage>::ThreadSafeList(const ThreadSafeList& other) {
+  std::lock_guard<std::mutex> lk(other.mut_);
+  data_list_ = other.data_list_;
+  PublishSize();
+}
+
+template <typename T, typename Storage>
+inline bool ThreadSafeList<T, Storage>::PushBack(const T& new_value) {
+  return PushElement(Store::MakeElement(new_value), false);
+}
+
+template <typename T, typename Storage>
+inline bool ThreadSafeList<T, Storage>::PushBack(T&& new_value) {
+  return PushElement(Store::MakeElement(std::move(new_value)), false);
+}
+
+template <typename T, typename Storage>
+inline bool ThreadSafeList<T, Storage>::PushFront(const T& new_value) {
+  return PushElement(Store::MakeElement(new_value), true);
+}
+
+template <typename T, typename Storage>
+inline bool ThreadSafeList<T, Storage>::PushFront(T&& new_value) {
+  return PushElement(Store::MakeElement(std::move(new_value)), true);
+}
+
+template <typename T, typename Storage>
+inline bool ThreadSafeList<T, Storage>::PushElement(
+    typename Store::Element&& element, bool front) {
+  std::unique_lock<std::mutex> lk(mut_);
+  if (closed_) {
+    return false;
+  }
+  if (front) {
+    data_list_.PushFront(std::move(element));
+  } else {
+    data_list_.PushBack(std::move(element));
+  }
+  PublishSize();
+  NotifyConsumers(lk, 1);
+  return true;
+}
+
+template <typename T, typename Storage>
+template <typename InputIt>
+bool ThreadSafeList<T, Storage>::PushBackRange(InputIt first, InputIt last) {
+  return PushElements(first, last, false);
+}
+
+template <typename T, typename Storage>
+template <typename InputIt>
+bool ThreadSafeList<T, Storage>::PushFrontRange(InputIt first, InputIt last) {
+  return PushElements(first, last, true);
+}
+
+template <typename T, typename Storage>
+template <typename InputIt>
+bool ThreadSafeList<T, Storage>::PushElements(InputIt first, InputIt last,
+                                              bool front) {
+  std::vector<typename Store::Element> elements;
+  for (; first != last; ++first) {
+    elements.push_back(Store::MakeElement(*first));
+  }
+  std::unique_lock<std::mutex> lk(mut_);
+  if (closed_) {
+    return false;
+  }
+  if (front) {
+    // Pushed last to first so the range keeps its order
+    for (auto it = elements.rbegin(); it != elements.rend(); ++it) {
+      data_list_.PushFront(std::move(*it));
+    }
+  } else {
+    for (auto& element : elements) {
+      data_list_.PushBack(std::move(element));
+    }
+  }
+  PublishSize();
+  NotifyConsumers(lk, elements.size());
+  return true;
+}
+
+template <typename T, typename Storage>
+inline bool ThreadSafeList<T, Storage>::WaitAndPopFront(T& value) {
+  std::unique_lock<std::mutex> lk(mut_);
+  WaitForData(lk);
+  if (data_list_.Empty()) {
+    return false;
+  }
+  data_list_.PopFront(value);
+  PublishSize();
+  return true;
+}
+
+template <typename T, typename Storage>
+inline std::shared_ptr<T> ThreadSafeList<T, Storage>::WaitAndPopFront() {
+  std::unique_lock<std::mutex> lk(mut_);
+  WaitForData(lk);
+  if (data_list_.Empty()) {
+    return std::shared_ptr<T>();
+  }
+  auto res = data_list_.PopFrontShared();
+  PublishSize();
+  return res;
+}
+
+template <typename T, typename Storage>
+template <typename Rep, typename Period>
+QueueStatus ThreadSafeList<T, Storage>::WaitAndPopFrontFor(
+    T& value, const std::chrono::duration<Rep, Period>& timeout) {
+  return WaitAndPopFrontUntil(value, std::chrono::steady_clock::now() +
+                                         timeout);
+}
+
+template <typename T, typename Storage>
+template <typename Clock, typename Duration>
+QueueStatus ThreadSafeList<T, Storage>::WaitAndPopFrontUntil(
+    T& value, const std::chrono::time_point<Clock, Duration>& deadline) {
+  std::unique_lock<std::mutex> lk(mut_);
+  QueueStatus status = WaitUntil(lk, deadline);
+  if (status == QueueStatus::kSuccess) {
+    data_list_.PopFront(value);
+    PublishSize();
+  }
+  return status;
+}
+
+template <typename T, typename Storage>
+inline bool ThreadSafeList<T, Storage>::TryPopFront(T& value) {
+  std::lock_guard<std::mutex> lk(mut_);
+  if (data_list_.Empty()) {
+    return false;
+  }
+  data_list_.PopFront(value);
+  PublishSize();
+  return true;
+}
+
+template <typename T, typename Storage>
+inline std::shared_ptr<T> ThreadSafeList<T, Storage>::TryPopFront() {
+  std::lock_guard<std::mutex> lk(mut_);
+  if (data_list_.Empty()) {
+    return std::shared_ptr<T>();
+  }
+  auto res = data_list_.PopFrontShared();
+  PublishSize();
+  return res;
+}
+
+template <typename T, typename Storage>
+inline bool ThreadSafeList<T, Storage>::WaitAndPopBack(T& value) {
+  std::unique_lock<std::mutex> lk(mut_);
+  WaitForData(lk);
+  if (data_list_.Empty()) {
+    return false;
+  }
+  data_list_.PopBack(value);
+  PublishSize();
+  return true;
+}
+
+template <typename T, typename Storage>
+inline std::shared_ptr<T> ThreadSafeList<T, Storage>::WaitAndPopBack() {
+  std::unique_lock<std::mutex> lk(mut_);
+  WaitForData(lk);
+  if (data_list_.Empty()) {
+    return std::shared_ptr<T>();
+  }
+  auto res = data_list_.PopBackShared();
+  PublishSize();
+  return res;
+}
+
+template <typename T, typename Storage>
+template <typename Rep, typename Period>
+QueueStatus ThreadSafeList<T, Storage>::WaitAndPopBackFor(
+    T& value, const std::chrono::duration<Rep, Period>& timeout) {
+  return WaitAndPopBackUntil(value, std::chrono::steady_clock::now() +
+                                        timeout);
+}
+
+template <typename T, typename Storage>
+template <typename Clock, typename Duration>
+QueueStatus ThreadSafeList<T, Storage>::WaitAndPopBackUntil(
+    T& value, const std::chrono::time_point<Clock, Duration>& deadline) {
+  std::unique_lock<std::mutex> lk(mut_);
+  QueueStatus status = WaitUntil(lk, deadline);
+  if (status == QueueStatus::kSuccess) {
+    data_list_.PopBack(value);
+    PublishSize();
+  }
+  return status;
+}
+
+template <typename T, typename Storage>
+inline bool ThreadSafeList<T, Storage>::TryPopBack(T& value) {
+  std::lock_guard<std::mutex> lk(mut_);
+  if (data_list_.Empty()) {
+    return false;
+  }
+  data_list_.PopBack(value);
+  PublishSize();
+  return true;
+}
+
+template <typename T, typename Storage>
+inline std::shared_ptr<T> ThreadSafeList<T, Storage>::TryPopBack() {
+  std::lock_guard<std::mutex> lk(mut_);
+  if (data_list_.Empty()) {
+    return std::shared_ptr<T>();
+  }
+  auto res = data_list_.PopBackShared();
+  PublishSize();
+  return res;
+}
+
+template <typename T, typename Storage>
+size_t ThreadSafeList<T, Storage>::PopAll(std::vector<T>& out) {
+  Store drained;
+  {
+    std::lock_guard<std::mutex> lk(mut_);
+    drained.Swap(data_list_);
+    PublishSize();
+  }
+  size_t count = drained.Size();
+  out.reserve(out.size() + count);
+  while (!drained.Empty()) {
+    drained.PopFrontTo(out);
+  }
+  return count;
+}
+
+template <typename T, typename Storage>
+size_t ThreadSafeList<T, Storage>::PopFrontUpTo(std::vector<T>& out,
+                                                size_t max_count) {
+  std::lock_guard<std::mutex> lk(mut_);
+  return PopFrontUpToLocked(out, max_count);
+}
+
+template <typename T, typename Storage>
+size_t ThreadSafeList<T, Storage>::PopBackUpTo(std::vector<T>& out,
+                                               size_t max_count) {
+  std::lock_guard<std::mutex> lk(mut_);
+  return PopBackUpToLocked(out, max_count);
+}
+
+template <typename T, typename Storage>
+template <typename Rep, typename Period>
+size_t ThreadSafeList<T, Storage>::WaitAndPopFrontUpTo(
+    std::vector<T>& out, size_t max_count,
+    const std::chrono::duration<Rep, Period>& timeout) {
+  std::unique_lock<std::mutex> lk(mut_);
+  if (WaitUntil(lk, std::chrono::steady_clock::now() + timeout) !=
+      QueueStatus::kSuccess) {
+    return 0;
+  }
+  return PopFrontUpToLocked(out, max_count);
+}
+
+template <typename T, typename Storage>
+template <typename Rep, typename Period>
+size_t ThreadSafeList<T, Storage>::WaitAndPopBackUpTo(
+    std::vector<T>& out, size_t max_count,
+    const std::chrono::duration<Rep, Period>& timeout) {
+  std::unique_lock<std::mutex> lk(mut_);
+  if (WaitUntil(lk, std::chrono::steady_clock::now() + timeout) !=
+      QueueStatus::kSuccess) {
+    return 0;
+  }
+  return PopBackUpToLocked(out, max_count);
+}
+
+template <typename T, typename Storage>
+size_t ThreadSafeList<T, Storage>::PopFrontUpToLocked(std::vector<T>& out,
+                                                      size_t max_count) {
+  size_t count = 0;
+  while (count < max_count && !data_list_.Empty()) {
+    data_list_.PopFrontTo(out);
+    count++;
+  }
+  PublishSize();
+  return count;
+}
+
+template <typename T, typename Storage>
+size_t ThreadSafeList<T, Storage>::PopBackUpToLocked(std::vector<T>& out,
+                                                     size_t max_count) {
+  size_t count = 0;
+  while (count < max_count && !data_list_.Empty()) {
+    data_list_.PopBackTo(out);
+    count++;
+  }
+  PublishSize();
+  return count;
+}
+
+template <typename T, typename Storage>
+inline void ThreadSafeList<T, Storage>::NotifyConsumers(
+    std::unique_lock<std::mutex>& lk, size_t count) {
+  if (count == 0 || waiting_consumers_ == 0) {
+    return;
+  }
+  bool wake_all = count > 1 && waiting_consumers_ > 1;
+  // A woken consumer must not block on the mutex still held here
+  lk.unlock();
+  if (wake_all) {
+    data_cond_.notify_all();
+  } else {
+    data_cond_.notify_one();
+  }
+}
+
+template <typename T, typename Storage>
+inline void ThreadSafeList<T, Storage>::WaitForData(
+    std::unique_lock<std::mutex>& lk) {
+  waiting_consumers_++;
+  data_cond_.wait(lk, [this] { return HasDataOrClosed(); });
+  waiting_consumers_--;
+}
+
+template <typename T, typename Storage>
+template <typename Clock, typename Duration>
+QueueStatus ThreadSafeList<T, Storage>::WaitUntil(
+    std::unique_lock<std::mutex>& lk,
+    const std::chrono::time_point<Clock, Duration>& deadline) {
+  waiting_consumers_++;
+  bool ready = data_cond_.wait_until(lk, deadline,
+                                     [this] { return HasDataOrClosed(); });
+  waiting_consumers_--;
+  if (!ready) {
+    return QueueStatus::kTimeout;
+  }
+  return data_list_.Empty() ? QueueStatus::kClosed : QueueStatus::kSuccess;
+}
+
+template <typename T, typename Storage>
+std::shared_ptr<T> ThreadSafeList<T, Storage>::Front() {
+  std::lock_guard<std::mutex> lk(mut_);
+  if (data_list_.Empty()) {
+    return std::shared_ptr<T>();
+  }
+  return data_list_.FrontShared();
+}
+
+template <typename T, typename Storage>
+std::shared_ptr<T> ThreadSafeList<T, Storage>::Back() {
+  std::lock_guard<std::mutex> lk(mut_);
+  if (data_list_.Empty()) {
+    return std::shared_ptr<T>();
+  }
+  return data_list_.BackShared();
+}
+
+template <typename T, typename Storage>
+void ThreadSafeList<T, Storage>::Close() {
+  std::lock_guard<std::mutex> lk(mut_);
+  closed_ = true;
+  data_cond_.notify_all();
+}
+
+template <typename T, typename Storage>
+bool ThreadSafeList<T, Storage>::IsClosed() const {
+  std::lock_guard<std::mutex> lk(mut_);
+  return closed_;
+}
+
+template <typename T, typename Storage>
+bool ThreadSafeList<T, Storage>::IsEmptyExact() const {
+  std::lock_guard<std::mutex> lk(mut_);
+  return data_list_.Empty();
+}
+
+template <typename T, typename Storage>
+void ThreadSafeList<T, Storage>::Clear() {
+  std::lock_guard<std::mutex> lk(mut_);
+  data_list_.Clear();
+  PublishSize();
+}
+
+template <typename T, typename Storage>
+size_t ThreadSafeList<T, Storage>::SizeExact() const {
+  std::lock_guard<std::mutex> lk(mut_);
+  return data_list_.Size();
+}
+
+// Common instantiations are compiled once into the library
+extern template class ThreadSafeList<int>;
+extern template class ThreadSafeList<std::string>;
+extern template class ThreadSafeList<int, ValueStorage>;
+extern template class ThreadSafeList<std::string, ValueStorage>;
+
 }  // namespace Utils
 
 #endif  // UTILS_THREAD_SAFE_LIST_H_
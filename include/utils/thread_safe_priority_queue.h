@@ -0,0 +1,268 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Thread safe priority queue backed by a d-ary heap.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#ifndef UTILS_THREAD_SAFE_PRIORITY_QUEUE_H_
+#define UTILS_THREAD_SAFE_PRIORITY_QUEUE_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "dary_heap.h"
+#include "queue_status.h"
+
+namespace Utils {
+
+/**
+ * Pops return the element that compares greatest under 'Compare', like
+ * std::priority_queue. For deadline ordering pass a comparator that puts the
+ * earliest deadline on top, i.e. one returning a.deadline > b.deadline.
+ */
+template <typename T, typename Compare = std::less<T> >
+class ThreadSafePriorityQueue {
+ public:
+  explicit ThreadSafePriorityQueue(const Compare& comp = Compare())
+      : heap_(comp) {}
+
+  ThreadSafePriorityQueue(const ThreadSafePriorityQueue& other) = delete;
+  ThreadSafePriorityQueue& operator=(const ThreadSafePriorityQueue& other) =
+      delete;
+
+  /**
+   * @return false if the queue is closed, the value is dropped then
+   */
+  bool Push(const T& new_value) { return Emplace(new_value); }
+
+  bool Push(T&& new_value) { return Emplace(std::move(new_value)); }
+
+  template <typename... Args>
+  bool Emplace(Args&&... args);
+
+  /**
+   * Block until an element is available.
+   * @return false if the queue was closed and is drained
+   */
+  bool WaitAndPop(T& value);
+
+  /**
+   * @return nullptr if the queue was closed and is drained
+   */
+  std::shared_ptr<T> WaitAndPop();
+
+  template <typename Rep, typename Period>
+  QueueStatus WaitAndPopFor(T& value,
+                            const std::chrono::duration<Rep, Period>& timeout);
+
+  template <typename Clock, typename Duration>
+  QueueStatus WaitAndPopUntil(
+      T& value, const std::chrono::time_point<Clock, Duration>& deadline);
+
+  /**
+   * Block until the top element is due, i.e. until the time point returned by
+   * 'deadline_of(top)' has passed, then pop it. A push that puts an earlier
+   * element on top wakes the waiter so it re-arms on the new deadline. After
+   * Close() the remaining elements are handed out without waiting.
+   * @return false if the queue was closed and is drained
+   */
+  template <typename DeadlineOf>
+  bool WaitAndPopWhenDue(T& value, DeadlineOf deadline_of);
+
+  bool TryPop(T& value);
+
+  std::shared_ptr<T> TryPop();
+
+  /**
+   * @return a copy of the top element, nullptr if empty
+   */
+  std::shared_ptr<T> Top() const;
+
+  /**
+   * Reject further pushes and wake every waiter. Elements already queued can
+   * still be popped.
+   */
+  void Close();
+
+  bool IsClosed() const;
+
+  bool IsEmpty() const;
+
+  void Clear();
+
+  size_t Size() const;
+
+ private:
+  bool HasDataOrClosed() const { return !heap_.Empty() || closed_; }
+
+  mutable std::mutex mut_;
+  DaryHeap<T, Compare> heap_;
+  std::condition_variable data_cond_;
+  bool closed_{false};
+
+  // WaitAndPopWhenDue sleeps on 'due_cond_' until the top is due
+  std::condition_variable due_cond_;
+  int due_waiters_{0};
+};
+
+template <typename T, typename Compare>
+template <typename... Args>
+inline bool ThreadSafePriorityQueue<T, Compare>::Emplace(Args&&... args) {
+  std::lock_guard<std::mutex> lk(mut_);
+  if (closed_) {
+    return false;
+  }
+  bool on_top = heap_.Emplace(std::forward<Args>(args)...);
+  data_cond_.notify_one();
+  // Only a new top can move the deadline a due waiter sleeps on
+  if (on_top && due_waiters_ > 0) {
+    due_cond_.notify_one();
+  }
+  return true;
+}
+
+template <typename T, typename Compare>
+bool ThreadSafePriorityQueue<T, Compare>::WaitAndPop(T& value) {
+  std::unique_lock<std::mutex> lk(mut_);
+  data_cond_.wait(lk, [this] { return HasDataOrClosed(); });
+  if (heap_.Empty()) {
+    return false;
+  }
+  heap_.Pop(value);
+  return true;
+}
+
+template <typename T, typename Compare>
+std::shared_ptr<T> ThreadSafePriorityQueue<T, Compare>::WaitAndPop() {
+  std::unique_lock<std::mutex> lk(mut_);
+  data_cond_.wait(lk, [this] { return HasDataOrClosed(); });
+  if (heap_.Empty()) {
+    return std::shared_ptr<T>();
+  }
+  return std::make_shared<T>(heap_.PopTop());
+}
+
+template <typename T, typename Compare>
+template <typename Rep, typename Period>
+QueueStatus ThreadSafePriorityQueue<T, Compare>::WaitAndPopFor(
+    T& value, const std::chrono::duration<Rep, Period>& timeout) {
+  return WaitAndPopUntil(value, std::chrono::steady_clock::now() + timeout);
+}
+
+template <typename T, typename Compare>
+template <typename Clock, typename Duration>
+QueueStatus ThreadSafePriorityQueue<T, Compare>::WaitAndPopUntil(
+    T& value, const std::chrono::time_point<Clock, Duration>& deadline) {
+  std::unique_lock<std::mutex> lk(mut_);
+  if (!data_cond_.wait_until(lk, deadline,
+                             [this] { return HasDataOrClosed(); })) {
+    return QueueStatus::kTimeout;
+  }
+  if (heap_.Empty()) {
+    return QueueStatus::kClosed;
+  }
+  heap_.Pop(value);
+  return QueueStatus::kSuccess;
+}
+
+template <typename T, typename Compare>
+template <typename DeadlineOf>
+bool ThreadSafePriorityQueue<T, Compare>::WaitAndPopWhenDue(
+    T& value, DeadlineOf deadline_of) {
+  std::unique_lock<std::mutex> lk(mut_);
+  due_waiters_++;
+  while (true) {
+    if (heap_.Empty()) {
+      if (closed_) {
+        due_waiters_--;
+        return false;
+      }
+      due_cond_.wait(lk);
+      continue;
+    }
+    if (closed_) {
+      break;
+    }
+    auto due = deadline_of(heap_.Top());
+    if (decltype(due)::clock::now() >= due) {
+      break;
+    }
+    due_cond_.wait_until(lk, due);
+  }
+  due_waiters_--;
+  heap_.Pop(value);
+  // Another due waiter may sleep on a deadline later than the new top's
+  if (due_waiters_ > 0 && !heap_.Empty()) {
+    due_cond_.notify_one();
+  }
+  return true;
+}
+
+template <typename T, typename Compare>
+bool ThreadSafePriorityQueue<T, Compare>::TryPop(T& value) {
+  std::lock_guard<std::mutex> lk(mut_);
+  if (heap_.Empty()) {
+    return false;
+  }
+  heap_.Pop(value);
+  return true;
+}
+
+template <typename T, typename Compare>
+std::shared_ptr<T> ThreadSafePriorityQueue<T, Compare>::TryPop() {
+  std::lock_guard<std::mutex> lk(mut_);
+  if (heap_.Empty()) {
+    return std::shared_ptr<T>();
+  }
+  return std::make_shared<T>(heap_.PopTop());
+}
+
+template <typename T, typename Compare>
+std::shared_ptr<T> ThreadSafePriorityQueue<T, Compare>::Top() const {
+  std::lock_guard<std::mutex> lk(mut_);
+  if (heap_.Empty()) {
+    return std::shared_ptr<T>();
+  }
+  return std::make_shared<T>(heap_.Top());
+}
+
+template <typename T, typename Compare>
+void ThreadSafePriorityQueue<T, Compare>::Close() {
+  std::lock_guard<std::mutex> lk(mut_);
+  closed_ = true;
+  data_cond_.notify_all();
+  due_cond_.notify_all();
+}
+
+template <typename T, typename Compare>
+bool ThreadSafePriorityQueue<T, Compare>::IsClosed() const {
+  std::lock_guard<std::mutex> lk(mut_);
+  return closed_;
+}
+
+template <typename T, typename Compare>
+bool ThreadSafePriorityQueue<T, Compare>::IsEmpty() const {
+  std::lock_guard<std::mutex> lk(mut_);
+  return heap_.Empty();
+}
+
+template <typename T, typename Compare>
+void ThreadSafePriorityQueue<T, Compare>::Clear() {
+  std::lock_guard<std::mutex> lk(mut_);
+  heap_.Clear();
+}
+
+template <typename T, typename Compare>
+size_t ThreadSafePriorityQueue<T, Compare>::Size() const {
+  std::lock_guard<std::mutex> lk(mut_);
+  return heap_.Size();
+}
+
+}  // namespace Utils
+
+#endif  // UTILS_THREAD_SAFE_PRIORITY_QUEUE_H_
@@ -8,47 +8,795 @@
 #ifndef UTILS_THREAD_SAFE_QUEUE_H_
 #define UTILS_THREAD_SAFE_QUEUE_H_
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstdint>
 #include <memory>
 #include <mutex>
-#include <queue>
+#include <string>
 #include <thread>
 #include <utility>
+#include <vector>
+
+#include "lock_free_common.h"
+#include "queue_notifier.h"
+#include "queue_status.h"
+#include "queue_storage.h"
+#include "queue_telemetry.h"
 
 namespace Utils {
-template <typename T>
+
+/**
+ * 'Storage' selects how elements are held, see queue_storage.h. The default
+ * SharedPtrStorage keeps the original behaviour; ValueStorage avoids the
+ * per-element shared_ptr allocation and is preferred for movable payloads.
+ *
+ * 'Telemetry' is NullTelemetry by default, which compiles to nothing. Pass
+ * QueueTelemetry to record rates, depth, sojourn and wait times, read back
+ * with GetTelemetry(), see queue_telemetry.h.
+ */
+template <typename T, typename Storage = SharedPtrStorage,
+          typename Telemetry = NullTelemetry>
 class ThreadSafeQueue {
  public:
   ThreadSafeQueue() = default;
 
+  /**
+   * Bounded queue holding at most 'capacity' elements, zero means unbounded.
+   * 'policy' decides what a push does while the queue is full.
+   */
+  explicit ThreadSafeQueue(size_t capacity,
+                           OverflowPolicy policy = OverflowPolicy::kBlock);
+
   ThreadSafeQueue(const ThreadSafeQueue& other);
 
-  void Push(const T& new_value);
+  /**
+   * @return false if the value was not enqueued: the queue is closed, or it
+   * is full and the policy rejected or dropped the new value
+   */
+  bool Push(const T& new_value);
+
+  bool Push(T&& new_value);
 
-  void WaitAndPop(T& value);
+  template <typename... Args>
+  bool Emplace(Args&&... args);
 
+  /**
+   * Like Push, but a producer blocked on a full queue gives up after
+   * 'timeout'.
+   */
+  template <typename Rep, typename Period>
+  bool PushFor(const T& new_value,
+               const std::chrono::duration<Rep, Period>& timeout);
+
+  template <typename Rep, typename Period>
+  bool PushFor(T&& new_value,
+               const std::chrono::duration<Rep, Period>& timeout);
+
+  /**
+   * Push [first, last) with one lock acquisition and one notification.
+   * @return false if any element was not enqueued
+   */
+  template <typename InputIt>
+  bool PushRange(InputIt first, InputIt last);
+
+  /**
+   * Block until an element is available.
+   * @return false if the queue was closed and is drained
+   */
+  bool WaitAndPop(T& value);
+
+  /**
+   * @return nullptr if the queue was closed and is drained
+   */
   std::shared_ptr<T> WaitAndPop();
 
+  template <typename Rep, typename Period>
+  QueueStatus WaitAndPopFor(T& value,
+                            const std::chrono::duration<Rep, Period>& timeout);
+
+  template <typename Clock, typename Duration>
+  QueueStatus WaitAndPopUntil(
+      T& value, const std::chrono::time_point<Clock, Duration>& deadline);
+
   bool TryPop(T& value);
 
   std::shared_ptr<T> TryPop();
 
+  /**
+   * Move every queued element to the end of 'out'. The queue is swapped out
+   * under the lock and drained after releasing it.
+   * @return number of elements popped
+   */
+  size_t PopAll(std::vector<T>& out);
+
+  /**
+   * Move at most 'max_count' elements to the end of 'out'.
+   * @return number of elements popped
+   */
+  size_t PopUpTo(std::vector<T>& out, size_t max_count);
+
+  /**
+   * Like PopUpTo, but wait up to 'timeout' for the first element.
+   * @return number of elements popped, zero on timeout or once the queue is
+   * closed and drained
+   */
+  template <typename Rep, typename Period>
+  size_t WaitAndPopUpTo(std::vector<T>& out, size_t max_count,
+                        const std::chrono::duration<Rep, Period>& timeout);
+
   std::shared_ptr<T> Front();
 
   std::shared_ptr<T> Back();
 
-  bool IsEmpty() const;
+  /**
+   * Reject further pushes and wake every waiter. Elements already queued can
+   * still be popped; blocking pops report closed once the queue is drained.
+   */
+  void Close();
+
+  bool IsClosed() const;
+
+  /**
+   * Lock-free, approximate while other threads push or pop. Use
+   * IsEmptyExact() when the answer must be consistent with the lock.
+   */
+  bool IsEmpty() const {
+    return size_hint_.load(std::memory_order_acquire) == 0;
+  }
+
+  bool IsEmptyExact() const;
 
   void Clear();
 
-  size_t Size() const;
+  /**
+   * Lock-free, approximate while other threads push or pop. The hint is
+   * published before 'mut_' is released or waited on, including by a
+   * PushRange() blocked halfway on a full queue, so it never lags behind
+   * SizeExact() once the pushing thread stops.
+   */
+  size_t Size() const { return size_hint_.load(std::memory_order_acquire); }
+
+  size_t SizeExact() const;
+
+  size_t Capacity() const { return capacity_; }
+
+  OverflowPolicy GetOverflowPolicy() const { return policy_; }
+
+  /**
+   * Select how consumers wait for an element, kBlocking by default. Spinning
+   * trades CPU time for handoff latency, a blocked consumer costs a futex
+   * sleep and wake-up.
+   */
+  void SetWaitStrategy(WaitStrategy strategy) {
+    wait_strategy_.store(strategy, std::memory_order_relaxed);
+  }
+
+  WaitStrategy GetWaitStrategy() const {
+    return wait_strategy_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Attach 'notifier', not owned, or detach it with nullptr. It is told when
+   * the queue goes from empty to non-empty and on Close(), see
+   * queue_notifier.h. Notify() runs outside the lock; SetNotifier() waits
+   * until no call of the previous notifier is in flight, so that one may be
+   * freed once this returns. Must not be called from Notify() itself.
+   */
+  void SetNotifier(QueueNotifier* notifier);
+
+  /**
+   * Elements discarded by kDropOldest or kDropNewest.
+   */
+  uint64_t GetDroppedCount() const;
+
+  /**
+   * Pushes failed by kReject or by a PushFor timeout.
+   */
+  uint64_t GetRejectedCount() const;
+
+  /**
+   * Total time producers spent blocked on a full queue.
+   */
+  std::chrono::nanoseconds GetProducerBlockTime() const;
+
+  /**
+   * Empty apart from the depth unless 'Telemetry' is QueueTelemetry.
+   */
+  QueueTelemetrySnapshot GetTelemetry() const;
 
  private:
+  typedef ElementStore<T, Storage> Store;
+  typedef std::chrono::steady_clock::time_point Deadline;
+
+  bool PushElement(typename Store::Element&& element,
+                   const Deadline* deadline);
+
+  // Make room for one element per the overflow policy. 'notify_pending' is
+  // set by a batch that pushed into an empty queue; the notifier is fired
+  // and the flag cleared before blocking on space
+  bool ReserveSlot(std::unique_lock<std::mutex>& lk, const Deadline* deadline,
+                   bool* notify_pending);
+
+  void NotifySpace(size_t freed);
+
+  // Take 'notifier_' for a call outside the lock, nullptr if none is set
+  QueueNotifier* BeginNotify() {
+    if (notifier_) {
+      notifying_++;
+    }
+    return notifier_;
+  }
+
+  // Under the lock, after the call of a notifier from BeginNotify()
+  void EndNotify() {
+    if (--notifying_ == 0) {
+      notifier_cond_.notify_all();
+    }
+  }
+
+  // Wake up to 'count' sleeping consumers and the notifier if the queue was
+  // empty before, after releasing 'lk'
+  void NotifyConsumers(std::unique_lock<std::mutex>& lk, size_t count,
+                       bool was_empty);
+
+  bool HasDataOrClosed() const { return !data_queue_.Empty() || closed_; }
+
+  // Called after every change of 'data_queue_' under the lock, before the
+  // lock is released or waited on
+  void PublishSize() {
+    size_hint_.store(data_queue_.Size(), std::memory_order_release);
+  }
+
+  bool HasDataHint() const {
+    return size_hint_.load(std::memory_order_acquire) > 0 ||
+           closed_.load(std::memory_order_acquire);
+  }
+
+  // Spin outside the lock as the wait strategy allows, true once an element
+  // or Close() was seen. 'bounded' limits kBusySpin to the spin-then-park
+  // budget
+  bool SpinForData(bool bounded) const;
+
+  // Lock 'lk' once an element is available or the queue is closed
+  void AwaitData(std::unique_lock<std::mutex>& lk);
+
+  bool HasSpaceOrClosed() const {
+    return data_queue_.Size() < capacity_ || closed_;
+  }
+
+  template <typename Clock, typename Duration>
+  QueueStatus WaitUntil(
+      std::unique_lock<std::mutex>& lk,
+      const std::chrono::time_point<Clock, Duration>& deadline);
+
+  size_t PopUpToLocked(std::vector<T>& out, size_t max_count);
+
   mutable std::mutex mut_;
-  std::queue<std::shared_ptr<T>> data_queue_;
+  Store data_queue_;
   std::condition_variable data_cond_;
+  std::atomic<bool> closed_{false};
+  // Consumers asleep on 'data_cond_', pushes skip the notify while zero
+  int waiting_consumers_{0};
+  QueueNotifier* notifier_{nullptr};
+  // Notify() calls running outside the lock, SetNotifier() waits for zero
+  // on 'notifier_cond_'
+  int notifying_{0};
+  std::condition_variable notifier_cond_;
+
+  static const int kSpinRounds = 16;
+  std::atomic<WaitStrategy> wait_strategy_{WaitStrategy::kBlocking};
+  // Mirrors data_queue_.Size() for spinning consumers and the lock-free
+  // Size() and IsEmpty()
+  std::atomic<size_t> size_hint_{0};
+
+  // Bounded mode, producers wait on 'space_cond_' with the kBlock policy
+  size_t capacity_{0};
+  OverflowPolicy policy_{OverflowPolicy::kBlock};
+  std::condition_variable space_cond_;
+  int blocked_producers_{0};
+  uint64_t dropped_count_{0};
+  uint64_t rejected_count_{0};
+  std::chrono::nanoseconds producer_block_time_{0};
+
+  // Guarded by 'mut_'
+  Telemetry telemetry_;
 };
 
+template <typename T, typename Storage, typename Telemetry>
+ThreadSafeQueue<T, Storage, Telemetry>::ThreadSafeQueue(size_t capacity,
+                                                        OverflowPolicy policy)
+    : capacity_(capacity), policy_(policy) {}
+
+template <typename T, typename Storage, typename Telemetry>
+ThreadSafeQueue<T, Storage, Telemetry>::ThreadSafeQueue(
+    const ThreadSafeQueue& other) {
+  std::lock_guard<std::mutex> lk(other.mut_);
+  data_queue_ = other.data_queue_;
+  capacity_ = other.capacity_;
+  policy_ = other.policy_;
+  wait_strategy_.store(other.GetWaitStrategy(), std::memory_order_relaxed);
+  PublishSize();
+  // The copies start their stay in this queue now
+  telemetry_.OnPush(data_queue_.Size(), data_queue_.Size());
+}
+
+template <typename T, typename Storage, typename Telemetry>
+inline bool ThreadSafeQueue<T, Storage, Telemetry>::Push(const T& new_value) {
+  return PushElement(Store::MakeElement(new_value), nullptr);
+}
+
+template <typename T, typename Storage, typename Telemetry>
+inline bool ThreadSafeQueue<T, Storage, Telemetry>::Push(T&& new_value) {
+  return PushElement(Store::MakeElement(std::move(new_value)), nullptr);
+}
+
+template <typename T, typename Storage, typename Telemetry>
+template <typename... Args>
+inline bool ThreadSafeQueue<T, Storage, Telemetry>::Emplace(Args&&... args) {
+  return PushElement(Store::MakeElement(std::forward<Args>(args)...),
+                     nullptr);
+}
+
+template <typename T, typename Storage, typename Telemetry>
+template <typename Rep, typename Period>
+bool ThreadSafeQueue<T, Storage, Telemetry>::PushFor(
+    const T& new_value, const std::chrono::duration<Rep, Period>& timeout) {
+  Deadline deadline = std::chrono::steady_clock::now() +
+                      std::chrono::duration_cast<Deadline::duration>(timeout);
+  return PushElement(Store::MakeElement(new_value), &deadline);
+}
+
+template <typename T, typename Storage, typename Telemetry>
+template <typename Rep, typename Period>
+bool ThreadSafeQueue<T, Storage, Telemetry>::PushFor(
+    T&& new_value, const std::chrono::duration<Rep, Period>& timeout) {
+  Deadline deadline = std::chrono::steady_clock::now() +
+                      std::chrono::duration_cast<Deadline::duration>(timeout);
+  return PushElement(Store::MakeElement(std::move(new_value)), &deadline);
+}
+
+template <typename T, typename Storage, typename Telemetry>
+inline bool ThreadSafeQueue<T, Storage, Telemetry>::PushElement(
+    typename Store::Element&& element, const Deadline* deadline) {
+  std::unique_lock<std::mutex> lk(mut_);
+  if (!ReserveSlot(lk, deadline, nullptr)) {
+    return false;
+  }
+  bool was_empty = data_queue_.Empty();
+  data_queue_.PushBack(std::move(element));
+  PublishSize();
+  telemetry_.OnPush(1, data_queue_.Size());
+  NotifyConsumers(lk, 1, was_empty);
+  return true;
+}
+
+template <typename T, typename Storage, typename Telemetry>
+template <typename InputIt>
+bool ThreadSafeQueue<T, Storage, Telemetry>::PushRange(InputIt first,
+                                                       InputIt last) {
+  std::vector<typename Store::Element> elements;
+  for (; first != last; ++first) {
+    elements.push_back(Store::MakeElement(*first));
+  }
+  std::unique_lock<std::mutex> lk(mut_);
+  // Set on every empty to non-empty transition not yet notified
+  bool notify_pending = false;
+  size_t pushed = 0;
+  for (auto& element : elements) {
+    if (!ReserveSlot(lk, nullptr, &notify_pending)) {
+      if (closed_) {
+        break;
+      }
+      continue;
+    }
+    notify_pending = notify_pending || data_queue_.Empty();
+    data_queue_.PushBack(std::move(element));
+    telemetry_.OnPush(1, data_queue_.Size());
+    pushed++;
+  }
+  PublishSize();
+  bool all_pushed = !closed_ && pushed == elements.size();
+  NotifyConsumers(lk, pushed, notify_pending);
+  return all_pushed;
+}
+
+template <typename T, typename Storage, typename Telemetry>
+bool ThreadSafeQueue<T, Storage, Telemetry>::ReserveSlot(
+    std::unique_lock<std::mutex>& lk, const Deadline* deadline,
+    bool* notify_pending) {
+  if (closed_) {
+    return false;
+  }
+  if (capacity_ == 0 || data_queue_.Size() < capacity_) {
+    return true;
+  }
+
+  switch (policy_) {
+    case OverflowPolicy::kReject:
+      rejected_count_++;
+      return false;
+    case OverflowPolicy::kDropNewest:
+      dropped_count_++;
+      return false;
+    case OverflowPolicy::kDropOldest:
+      data_queue_.DropFront();
+      telemetry_.OnDiscard(1, data_queue_.Size());
+      dropped_count_++;
+      return true;
+    case OverflowPolicy::kBlock:
+    default:
+      break;
+  }
+
+  // Elements pushed earlier in this batch must be visible before blocking,
+  // spinning consumers only look at the size hint
+  PublishSize();
+  // Consumers may still be asleep on elements pushed by this batch
+  if (waiting_consumers_ > 0) {
+    data_cond_.notify_all();
+  }
+  // A notifier driven consumer only drains after its notification
+  if (notify_pending && *notify_pending) {
+    *notify_pending = false;
+    QueueNotifier* notifier = BeginNotify();
+    if (notifier) {
+      lk.unlock();
+      notifier->Notify();
+      lk.lock();
+      EndNotify();
+      // The queue may have drained or closed meanwhile
+      return ReserveSlot(lk, deadline, notify_pending);
+    }
+  }
+  auto start = std::chrono::steady_clock::now();
+  blocked_producers_++;
+  bool has_space = true;
+  if (deadline) {
+    has_space = space_cond_.wait_until(lk, *deadline,
+                                       [this] { return HasSpaceOrClosed(); });
+  } else {
+    space_cond_.wait(lk, [this] { return HasSpaceOrClosed(); });
+  }
+  blocked_producers_--;
+  producer_block_time_ += std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start);
+  if (!has_space) {
+    rejected_count_++;
+    return false;
+  }
+  return !closed_;
+}
+
+template <typename T, typename Storage, typename Telemetry>
+bool ThreadSafeQueue<T, Storage, Telemetry>::SpinForData(bool bounded) const {
+  WaitStrategy strategy = wait_strategy_.load(std::memory_order_relaxed);
+  if (strategy == WaitStrategy::kBlocking) {
+    return false;
+  }
+  if (strategy == WaitStrategy::kBusySpin && !bounded) {
+    while (!HasDataHint()) {
+      CpuRelax();
+    }
+    return true;
+  }
+  Backoff backoff;
+  for (int round = 0; round < kSpinRounds; round++) {
+    if (HasDataHint()) {
+      return true;
+    }
+    backoff.Pause();
+  }
+  return HasDataHint();
+}
+
+template <typename T, typename Storage, typename Telemetry>
+inline void ThreadSafeQueue<T, Storage, Telemetry>::AwaitData(
+    std::unique_lock<std::mutex>& lk) {
+  while (SpinForData(false)) {
+    lk.lock();
+    if (HasDataOrClosed()) {
+      return;
+    }
+    // Another consumer took the element
+    lk.unlock();
+  }
+  lk.lock();
+  waiting_consumers_++;
+  data_cond_.wait(lk, [this] { return HasDataOrClosed(); });
+  waiting_consumers_--;
+}
+
+template <typename T, typename Storage, typename Telemetry>
+inline void ThreadSafeQueue<T, Storage, Telemetry>::NotifyConsumers(
+    std::unique_lock<std::mutex>& lk, size_t count, bool was_empty) {
+  if (count == 0 || (waiting_consumers_ == 0 && !(was_empty && notifier_))) {
+    return;
+  }
+  QueueNotifier* notifier = was_empty ? BeginNotify() : nullptr;
+  int waiting = waiting_consumers_;
+  // A woken consumer must not block on the mutex still held here
+  lk.unlock();
+  if (waiting > 1 && count > 1) {
+    data_cond_.notify_all();
+  } else if (waiting > 0) {
+    data_cond_.notify_one();
+  }
+  if (notifier) {
+    notifier->Notify();
+    lk.lock();
+    EndNotify();
+  }
+}
+
+template <typename T, typename Storage, typename Telemetry>
+void ThreadSafeQueue<T, Storage, Telemetry>::SetNotifier(
+    QueueNotifier* notifier) {
+  std::unique_lock<std::mutex> lk(mut_);
+  notifier_ = notifier;
+  notifier_cond_.wait(lk, [this] { return notifying_ == 0; });
+}
+
+template <typename T, typename Storage, typename Telemetry>
+inline void ThreadSafeQueue<T, Storage, Telemetry>::NotifySpace(size_t freed) {
+  // Only producers blocked on a full queue wait for space
+  if (blocked_producers_ == 0 || freed == 0) {
+    return;
+  }
+  if (freed == 1) {
+    space_cond_.notify_one();
+  } else {
+    space_cond_.notify_all();
+  }
+}
+
+template <typename T, typename Storage, typename Telemetry>
+inline bool ThreadSafeQueue<T, Storage, Telemetry>::WaitAndPop(T& value) {
+  std::unique_lock<std::mutex> lk(mut_, std::defer_lock);
+  int64_t start = Telemetry::Now();
+  AwaitData(lk);
+  telemetry_.OnConsumerWait(start);
+  if (data_queue_.Empty()) {
+    return false;
+  }
+  data_queue_.PopFront(value);
+  PublishSize();
+  telemetry_.OnPop(1, data_queue_.Size());
+  NotifySpace(1);
+  return true;
+}
+
+template <typename T, typename Storage, typename Telemetry>
+inline std::shared_ptr<T> ThreadSafeQueue<T, Storage, Telemetry>::WaitAndPop() {
+  std::unique_lock<std::mutex> lk(mut_, std::defer_lock);
+  int64_t start = Telemetry::Now();
+  AwaitData(lk);
+  telemetry_.OnConsumerWait(start);
+  if (data_queue_.Empty()) {
+    return std::shared_ptr<T>();
+  }
+  auto res = data_queue_.PopFrontShared();
+  PublishSize();
+  telemetry_.OnPop(1, data_queue_.Size());
+  NotifySpace(1);
+  return res;
+}
+
+template <typename T, typename Storage, typename Telemetry>
+template <typename Rep, typename Period>
+QueueStatus ThreadSafeQueue<T, Storage, Telemetry>::WaitAndPopFor(
+    T& value, const std::chrono::duration<Rep, Period>& timeout) {
+  return WaitAndPopUntil(value, std::chrono::steady_clock::now() + timeout);
+}
+
+template <typename T, typename Storage, typename Telemetry>
+template <typename Clock, typename Duration>
+QueueStatus ThreadSafeQueue<T, Storage, Telemetry>::WaitAndPopUntil(
+    T& value, const std::chrono::time_point<Clock, Duration>& deadline) {
+  int64_t start = Telemetry::Now();
+  SpinForData(true);
+  std::unique_lock<std::mutex> lk(mut_);
+  QueueStatus status = WaitUntil(lk, deadline);
+  telemetry_.OnConsumerWait(start);
+  if (status == QueueStatus::kSuccess) {
+    data_queue_.PopFront(value);
+    PublishSize();
+    telemetry_.OnPop(1, data_queue_.Size());
+    NotifySpace(1);
+  }
+  return status;
+}
+
+template <typename T, typename Storage, typename Telemetry>
+inline bool ThreadSafeQueue<T, Storage, Telemetry>::TryPop(T& value) {
+  std::lock_guard<std::mutex> lk(mut_);
+  if (data_queue_.Empty()) {
+    return false;
+  }
+  data_queue_.PopFront(value);
+  PublishSize();
+  telemetry_.OnPop(1, data_queue_.Size());
+  NotifySpace(1);
+  return true;
+}
+
+template <typename T, typename Storage, typename Telemetry>
+inline std::shared_ptr<T> ThreadSafeQueue<T, Storage, Telemetry>::TryPop() {
+  std::lock_guard<std::mutex> lk(mut_);
+  if (data_queue_.Empty()) {
+    return std::shared_ptr<T>();
+  }
+  auto res = data_queue_.PopFrontShared();
+  PublishSize();
+  telemetry_.OnPop(1, data_queue_.Size());
+  NotifySpace(1);
+  return res;
+}
+
+template <typename T, typename Storage, typename Telemetry>
+size_t ThreadSafeQueue<T, Storage, Telemetry>::PopAll(std::vector<T>& out) {
+  Store drained;
+  {
+    std::lock_guard<std::mutex> lk(mut_);
+    drained.Swap(data_queue_);
+    PublishSize();
+    telemetry_.OnPop(drained.Size(), 0);
+    NotifySpace(drained.Size());
+  }
+  size_t count = drained.Size();
+  out.reserve(out.size() + count);
+  while (!drained.Empty()) {
+    drained.PopFrontTo(out);
+  }
+  return count;
+}
+
+template <typename T, typename Storage, typename Telemetry>
+size_t ThreadSafeQueue<T, Storage, Telemetry>::PopUpTo(std::vector<T>& out,
+                                                      size_t max_count) {
+  std::lock_guard<std::mutex> lk(mut_);
+  return PopUpToLocked(out, max_count);
+}
+
+template <typename T, typename Storage, typename Telemetry>
+template <typename Rep, typename Period>
+size_t ThreadSafeQueue<T, Storage, Telemetry>::WaitAndPopUpTo(
+    std::vector<T>& out, size_t max_count,
+    const std::chrono::duration<Rep, Period>& timeout) {
+  int64_t start = Telemetry::Now();
+  SpinForData(true);
+  std::unique_lock<std::mutex> lk(mut_);
+  QueueStatus status =
+      WaitUntil(lk, std::chrono::steady_clock::now() + timeout);
+  telemetry_.OnConsumerWait(start);
+  if (status != QueueStatus::kSuccess) {
+    return 0;
+  }
+  return PopUpToLocked(out, max_count);
+}
+
+template <typename T, typename Storage, typename Telemetry>
+size_t ThreadSafeQueue<T, Storage, Telemetry>::PopUpToLocked(
+    std::vector<T>& out, size_t max_count) {
+  size_t count = 0;
+  while (count < max_count && !data_queue_.Empty()) {
+    data_queue_.PopFrontTo(out);
+    count++;
+  }
+  PublishSize();
+  telemetry_.OnPop(count, data_queue_.Size());
+  NotifySpace(count);
+  return count;
+}
+
+template <typename T, typename Storage, typename Telemetry>
+template <typename Clock, typename Duration>
+QueueStatus ThreadSafeQueue<T, Storage, Telemetry>::WaitUntil(
+    std::unique_lock<std::mutex>& lk,
+    const std::chrono::time_point<Clock, Duration>& deadline) {
+  waiting_consumers_++;
+  bool ready = data_cond_.wait_until(lk, deadline,
+                                     [this] { return HasDataOrClosed(); });
+  waiting_consumers_--;
+  if (!ready) {
+    return QueueStatus::kTimeout;
+  }
+  return data_queue_.Empty() ? QueueStatus::kClosed : QueueStatus::kSuccess;
+}
+
+template <typename T, typename Storage, typename Telemetry>
+std::shared_ptr<T> ThreadSafeQueue<T, Storage, Telemetry>::Front() {
+  std::lock_guard<std::mutex> lk(mut_);
+  if (data_queue_.Empty()) {
+    return std::shared_ptr<T>();
+  }
+  return data_queue_.FrontShared();
+}
+
+template <typename T, typename Storage, typename Telemetry>
+std::shared_ptr<T> ThreadSafeQueue<T, Storage, Telemetry>::Back() {
+  std::lock_guard<std::mutex> lk(mut_);
+  if (data_queue_.Empty()) {
+    return std::shared_ptr<T>();
+  }
+  return data_queue_.BackShared();
+}
+
+template <typename T, typename Storage, typename Telemetry>
+void ThreadSafeQueue<T, Storage, Telemetry>::Close() {
+  std::unique_lock<std::mutex> lk(mut_);
+  closed_ = true;
+  data_cond_.notify_all();
+  space_cond_.notify_all();
+  QueueNotifier* notifier = BeginNotify();
+  if (notifier) {
+    lk.unlock();
+    notifier->Notify();
+    lk.lock();
+    EndNotify();
+  }
+}
+
+template <typename T, typename Storage, typename Telemetry>
+bool ThreadSafeQueue<T, Storage, Telemetry>::IsClosed() const {
+  std::lock_guard<std::mutex> lk(mut_);
+  return closed_;
+}
+
+template <typename T, typename Storage, typename Telemetry>
+bool ThreadSafeQueue<T, Storage, Telemetry>::IsEmptyExact() const {
+  std::lock_guard<std::mutex> lk(mut_);
+  return data_queue_.Empty();
+}
+
+template <typename T, typename Storage, typename Telemetry>
+void ThreadSafeQueue<T, Storage, Telemetry>::Clear() {
+  std::lock_guard<std::mutex> lk(mut_);
+  NotifySpace(data_queue_.Size());
+  telemetry_.OnDiscard(data_queue_.Size(), 0);
+  data_queue_.Clear();
+  PublishSize();
+}
+
+template <typename T, typename Storage, typename Telemetry>
+size_t ThreadSafeQueue<T, Storage, Telemetry>::SizeExact() const {
+  std::lock_guard<std::mutex> lk(mut_);
+  return data_queue_.Size();
+}
+
+template <typename T, typename Storage, typename Telemetry>
+uint64_t ThreadSafeQueue<T, Storage, Telemetry>::GetDroppedCount() const {
+  std::lock_guard<std::mutex> lk(mut_);
+  return dropped_count_;
+}
+
+template <typename T, typename Storage, typename Telemetry>
+uint64_t ThreadSafeQueue<T, Storage, Telemetry>::GetRejectedCount() const {
+  std::lock_guard<std::mutex> lk(mut_);
+  return rejected_count_;
+}
+
+template <typename T, typename Storage, typename Telemetry>
+std::chrono::nanoseconds
+ThreadSafeQueue<T, Storage, Telemetry>::GetProducerBlockTime() const {
+  std::lock_guard<std::mutex> lk(mut_);
+  return producer_block_time_;
+}
+
+template <typename T, typename Storage, typename Telemetry>
+QueueTelemetrySnapshot ThreadSafeQueue<T, Storage, Telemetry>::GetTelemetry()
+    const {
+  std::lock_guard<std::mutex> lk(mut_);
+  return telemetry_.Snapshot(data_queue_.Size());
+}
+
+// Common instantiations are compiled once into the library
+extern template class ThreadSafeQueue<int>;
+extern template class ThreadSafeQueue<std::string>;
+extern template class ThreadSafeQueue<int, ValueStorage>;
+extern template class ThreadSafeQueue<std::string, ValueStorage>;
+
 }  // namespace Utils
 
 #endif  // UTILS_THREAD_SAFE_QUEUE_H_
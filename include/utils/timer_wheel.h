@@ -0,0 +1,203 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Hierarchical timing wheel for large numbers of timeouts.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#ifndef UTILS_TIMER_WHEEL_H_
+#define UTILS_TIMER_WHEEL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "timestamp.h"
+
+namespace Utils {
+
+/**
+ * Hashed hierarchical timing wheel driven by GetTimeStamp(), milliseconds.
+ * Time is cut into ticks of 'tick_ms'. Level 0 has one slot per tick, every
+ * higher level one slot per full turn of the level below, so five levels of
+ * 256 slots span 2^40 ticks; later timers are parked in the top level and
+ * re-placed once it turns. Schedule() and Cancel() are O(1), Advance() is
+ * O(1) per tick plus the timers it fires or moves down a level.
+ *
+ * Timers fire on the first Advance() at or after their expiry rounded up to
+ * a tick, never early. Not thread safe, see ThreadSafeTimerWheel.
+ */
+class TimerWheel {
+ public:
+  typedef std::function<void()> Callback;
+  typedef uint64_t TimerId;
+
+  // Never returned by Schedule(), Cancel() ignores it
+  static const TimerId kInvalidTimer = 0;
+
+  /**
+   * @param tick_ms resolution, timers are rounded up to it
+   * @param now time of tick zero
+   */
+  explicit TimerWheel(TimeStamp tick_ms = 1, TimeStamp now = GetTimeStamp());
+
+  TimerWheel(const TimerWheel &other) = delete;
+  TimerWheel &operator=(const TimerWheel &other) = delete;
+
+  /**
+   * Fire 'callback' 'delay_ms' after GetTimeStamp().
+   */
+  TimerId Schedule(TimeStamp delay_ms, Callback callback);
+
+  /**
+   * Fire 'callback' at 'when', on the next Advance() if it already passed.
+   */
+  TimerId ScheduleAt(TimeStamp when, Callback callback);
+
+  /**
+   * @return false if 'id' already fired or was cancelled
+   */
+  bool Cancel(TimerId id);
+
+  /**
+   * Fire every timer due at 'now'. Callbacks run after the wheel is updated
+   * and may schedule or cancel timers.
+   * @return number of timers fired
+   */
+  size_t Advance(TimeStamp now);
+
+  /**
+   * Like Advance, but append the due callbacks to 'expired' instead of
+   * running them, so a caller can run the batch outside its own lock.
+   */
+  size_t Advance(TimeStamp now, std::vector<Callback> &expired);
+
+  /**
+   * @return when Advance() next has work, -1 if no timer is pending. This is
+   * the next expiry if it is within the current turn of level 0, otherwise
+   * the start of the next turn, so a sleeping driver wakes at least once per
+   * 256 ticks.
+   */
+  TimeStamp GetNextExpiry() const;
+
+  size_t Size() const { return size_; }
+
+  bool IsEmpty() const { return size_ == 0; }
+
+  TimeStamp GetTickMs() const { return tick_ms_; }
+
+  /**
+   * Preallocate room for 'count' pending timers.
+   */
+  void Reserve(size_t count) { nodes_.reserve(count); }
+
+ private:
+  static const size_t kLevels = 5;
+  static const size_t kSlotBits = 8;
+  static const size_t kSlots = 1 << kSlotBits;
+  static const uint64_t kSlotMask = kSlots - 1;
+  static const uint32_t kNil = 0xFFFFFFFF;
+  // Timers scheduled for a tick already processed, fired by the next
+  // Advance()
+  static const uint32_t kOverdueSlot = kLevels * kSlots;
+
+  // Timers live in 'nodes_' and are chained per slot by index, freed nodes
+  // are chained through 'next' from 'free_head_'
+  struct Node {
+    Callback callback;
+    uint64_t expiry{0};
+    uint32_t prev{kNil};
+    uint32_t next{kNil};
+    // kNil while free
+    uint32_t slot{kNil};
+    // Bumped on release so stale ids do not cancel a reused node
+    uint32_t generation{1};
+  };
+
+  uint32_t Allocate();
+
+  void Release(uint32_t index);
+
+  // Put a node in the slot its expiry maps to relative to 'current_tick_'
+  void Link(uint32_t index);
+
+  void LinkToSlot(uint32_t index, uint32_t slot);
+
+  void Unlink(uint32_t index);
+
+  // Move every node of the 'level' slot 'tick' falls in down the wheel
+  void Cascade(size_t level, uint64_t tick);
+
+  // Detach a slot, collect its due nodes and re-link the others
+  size_t FireSlot(uint32_t slot, std::vector<Callback> &expired);
+
+  const TimeStamp tick_ms_;
+  const TimeStamp origin_;
+  // Next tick Advance() processes
+  uint64_t current_tick_{0};
+  size_t size_{0};
+  std::vector<Node> nodes_;
+  uint32_t free_head_{kNil};
+  uint32_t heads_[kOverdueSlot + 1];
+};  // class TimerWheel
+
+/**
+ * TimerWheel behind a mutex, so any thread can schedule and cancel. One
+ * thread drives it, either by calling Run() until Stop(), or from its own
+ * loop through Advance() and GetNextExpiry(). Due callbacks are collected
+ * under the lock and run as a batch after releasing it, on the driving
+ * thread. Cancel() returns false once the callback is in such a batch.
+ */
+class ThreadSafeTimerWheel {
+ public:
+  typedef TimerWheel::Callback Callback;
+  typedef TimerWheel::TimerId TimerId;
+
+  explicit ThreadSafeTimerWheel(TimeStamp tick_ms = 1);
+
+  ThreadSafeTimerWheel(const ThreadSafeTimerWheel &other) = delete;
+  ThreadSafeTimerWheel &operator=(const ThreadSafeTimerWheel &other) = delete;
+
+  TimerId Schedule(TimeStamp delay_ms, Callback callback);
+
+  TimerId ScheduleAt(TimeStamp when, Callback callback);
+
+  bool Cancel(TimerId id);
+
+  /**
+   * Fire every timer due at 'now' on the calling thread.
+   * @return number of timers fired
+   */
+  size_t Advance(TimeStamp now);
+
+  TimeStamp GetNextExpiry() const;
+
+  /**
+   * Drive the wheel from GetTimeStamp(), sleeping until the next expiry or
+   * an earlier Schedule(), until Stop(). The thread calling Run() must be
+   * joined before the wheel is destroyed.
+   */
+  void Run();
+
+  void Stop();
+
+  size_t Size() const;
+
+ private:
+  static void RunBatch(std::vector<Callback> &batch);
+
+  mutable std::mutex mut_;
+  std::condition_variable cond_;
+  TimerWheel wheel_;
+  bool stopped_{false};
+  // Run() is asleep until 'wake_at_', -1 for no deadline
+  bool sleeping_{false};
+  TimeStamp wake_at_{-1};
+};  // class ThreadSafeTimerWheel
+
+}  // namespace Utils
+
+#endif  // UTILS_TIMER_WHEEL_H_
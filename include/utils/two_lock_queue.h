@@ -0,0 +1,434 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Two-lock concurrent queue, producers and consumers lock different
+ * ends.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#ifndef UTILS_TWO_LOCK_QUEUE_H_
+#define UTILS_TWO_LOCK_QUEUE_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "mempool.h"
+#include "queue_status.h"
+
+namespace Utils {
+
+/**
+ * Linked queue after Michael and Scott with a dummy head node: producers only
+ * take 'tail_mutex_' and consumers only take 'head_mutex_', so a push and a
+ * pop proceed in parallel.
+ *
+ * Nodes are recycled without a lock shared by both sides. Consumers collect
+ * retired dummies under 'head_mutex_' and hand them over in batches through
+ * one atomic pointer; producers take such a batch, or refill from a
+ * MemPoolEx owned by the queue, under 'tail_mutex_'. The element is built
+ * before taking the lock and moved into its node.
+ *
+ * The public API mirrors ThreadSafeQueue. Elements are stored by value, the
+ * shared_ptr returning calls move the element into a new shared_ptr.
+ */
+template <typename T>
+class TwoLockQueue {
+ public:
+  /**
+   * @param pre_alloc number of nodes allocated up front
+   */
+  explicit TwoLockQueue(int pre_alloc = 0);
+
+  ~TwoLockQueue();
+
+  TwoLockQueue(const TwoLockQueue& other) = delete;
+  TwoLockQueue& operator=(const TwoLockQueue& other) = delete;
+
+  /**
+   * @return false if the queue is closed, the value is dropped then
+   */
+  bool Push(const T& new_value) { return Emplace(new_value); }
+
+  bool Push(T&& new_value) { return Emplace(std::move(new_value)); }
+
+  template <typename... Args>
+  bool Emplace(Args&&... args);
+
+  /**
+   * Block until an element is available.
+   * @return false if the queue was closed and is drained
+   */
+  bool WaitAndPop(T& value);
+
+  /**
+   * @return nullptr if the queue was closed and is drained
+   */
+  std::shared_ptr<T> WaitAndPop();
+
+  template <typename Rep, typename Period>
+  QueueStatus WaitAndPopFor(T& value,
+                            const std::chrono::duration<Rep, Period>& timeout);
+
+  template <typename Clock, typename Duration>
+  QueueStatus WaitAndPopUntil(
+      T& value, const std::chrono::time_point<Clock, Duration>& deadline);
+
+  bool TryPop(T& value);
+
+  std::shared_ptr<T> TryPop();
+
+  /**
+   * @return a copy of the head element, nullptr if empty
+   */
+  std::shared_ptr<T> Front();
+
+  /**
+   * @return a copy of the tail element, nullptr if empty
+   */
+  std::shared_ptr<T> Back();
+
+  /**
+   * Reject further pushes and wake every waiter. Elements already queued can
+   * still be popped.
+   */
+  void Close();
+
+  bool IsClosed() const { return closed_.load(std::memory_order_acquire); }
+
+  bool IsEmpty() const { return Size() == 0; }
+
+  void Clear();
+
+  /**
+   * Approximate under concurrent access.
+   */
+  size_t Size() const;
+
+ private:
+  struct Node {
+    std::atomic<Node*> next{nullptr};
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+    T* Value() { return reinterpret_cast<T*>(&storage); }
+
+    // Called by MemPoolEx when the node is released
+    void Reset() { next.store(nullptr, std::memory_order_relaxed); }
+  };
+
+  typedef std::chrono::steady_clock::time_point Deadline;
+
+  // Nodes moved between the pool, the producers and the consumers at a time
+  static const size_t kNodeBatch = 32;
+
+  // Under 'tail_mutex_'
+  Node* TakeNode();
+
+  // Under 'head_mutex_', 'node' holds no element
+  void RetireNode(Node* node);
+
+  // Return a chain linked through 'next' to the pool
+  void ReleaseChain(Node* node);
+
+  // Pops into 'value' under 'head_mutex_', false if the queue is empty
+  bool PopLocked(T& value);
+
+  bool PopSharedLocked(std::shared_ptr<T>& res);
+
+  template <typename Clock, typename Duration>
+  QueueStatus WaitLocked(
+      std::unique_lock<std::mutex>& lk,
+      const std::chrono::time_point<Clock, Duration>* deadline);
+
+  std::shared_ptr<MemPoolEx<Node> > pool_;
+
+  std::mutex head_mutex_;
+  Node* head_;
+  std::condition_variable data_cond_;
+  std::atomic<int> waiting_consumers_{0};
+  // Retired nodes not handed over yet
+  Node* retired_{nullptr};
+  size_t retired_count_{0};
+
+  std::mutex tail_mutex_;
+  Node* tail_;
+  // Spare nodes for pushes
+  Node* free_nodes_{nullptr};
+
+  // A batch of retired nodes, only consumers set it and only producers take
+  // it, so no ABA can occur
+  std::atomic<Node*> handoff_{nullptr};
+
+  std::atomic<ptrdiff_t> size_{0};
+  std::atomic<bool> closed_{false};
+};
+
+template <typename T>
+TwoLockQueue<T>::TwoLockQueue(int pre_alloc)
+    : pool_(MemPoolEx<Node>::Create(pre_alloc + 1, 0)) {
+  head_ = tail_ = TakeNode();
+}
+
+template <typename T>
+TwoLockQueue<T>::~TwoLockQueue() {
+  Node* node = head_->next.load(std::memory_order_relaxed);
+  for (; node; node = node->next.load(std::memory_order_relaxed)) {
+    node->Value()->~T();
+  }
+  ReleaseChain(head_);
+  ReleaseChain(retired_);
+  ReleaseChain(free_nodes_);
+  ReleaseChain(handoff_.load(std::memory_order_acquire));
+}
+
+template <typename T>
+typename TwoLockQueue<T>::Node* TwoLockQueue<T>::TakeNode() {
+  if (free_nodes_ == nullptr) {
+    free_nodes_ = handoff_.exchange(nullptr, std::memory_order_acquire);
+  }
+  if (free_nodes_ == nullptr) {
+    for (size_t i = 0; i < kNodeBatch; i++) {
+      Node* node = pool_->GetEx();
+      if (node == nullptr) {
+        break;
+      }
+      node->next.store(free_nodes_, std::memory_order_relaxed);
+      free_nodes_ = node;
+    }
+    if (free_nodes_ == nullptr) {
+      throw std::bad_alloc();
+    }
+  }
+  Node* node = free_nodes_;
+  free_nodes_ = node->next.load(std::memory_order_relaxed);
+  node->next.store(nullptr, std::memory_order_relaxed);
+  return node;
+}
+
+template <typename T>
+inline void TwoLockQueue<T>::RetireNode(Node* node) {
+  node->next.store(retired_, std::memory_order_relaxed);
+  retired_ = node;
+  retired_count_++;
+  // Producers empty 'handoff_' before taking from the pool, until then keep
+  // collecting
+  if (retired_count_ >= kNodeBatch &&
+      handoff_.load(std::memory_order_relaxed) == nullptr) {
+    handoff_.store(retired_, std::memory_order_release);
+    retired_ = nullptr;
+    retired_count_ = 0;
+  }
+}
+
+template <typename T>
+void TwoLockQueue<T>::ReleaseChain(Node* node) {
+  while (node) {
+    Node* next = node->next.load(std::memory_order_relaxed);
+    pool_->Release(node);
+    node = next;
+  }
+}
+
+template <typename T>
+template <typename... Args>
+inline bool TwoLockQueue<T>::Emplace(Args&&... args) {
+  if (closed_.load(std::memory_order_acquire)) {
+    return false;
+  }
+  T value(std::forward<Args>(args)...);
+  {
+    std::lock_guard<std::mutex> lk(tail_mutex_);
+    if (closed_.load(std::memory_order_relaxed)) {
+      return false;
+    }
+    Node* node = TakeNode();
+    new (node->Value()) T(std::move(value));
+    size_.fetch_add(1, std::memory_order_relaxed);
+    tail_->next.store(node, std::memory_order_seq_cst);
+    tail_ = node;
+  }
+  // Pairs with WaitLocked: either the consumer sees the new node, or this
+  // load sees the consumer announced itself
+  if (waiting_consumers_.load(std::memory_order_seq_cst) > 0) {
+    std::lock_guard<std::mutex> lk(head_mutex_);
+    data_cond_.notify_one();
+  }
+  return true;
+}
+
+template <typename T>
+inline bool TwoLockQueue<T>::PopLocked(T& value) {
+  Node* next = head_->next.load(std::memory_order_acquire);
+  if (next == nullptr) {
+    return false;
+  }
+  value = std::move(*next->Value());
+  next->Value()->~T();
+  Node* old_head = head_;
+  head_ = next;
+  size_.fetch_sub(1, std::memory_order_relaxed);
+  RetireNode(old_head);
+  return true;
+}
+
+template <typename T>
+inline bool TwoLockQueue<T>::PopSharedLocked(std::shared_ptr<T>& res) {
+  Node* next = head_->next.load(std::memory_order_acquire);
+  if (next == nullptr) {
+    return false;
+  }
+  res = std::make_shared<T>(std::move(*next->Value()));
+  next->Value()->~T();
+  Node* old_head = head_;
+  head_ = next;
+  size_.fetch_sub(1, std::memory_order_relaxed);
+  RetireNode(old_head);
+  return true;
+}
+
+template <typename T>
+template <typename Clock, typename Duration>
+QueueStatus TwoLockQueue<T>::WaitLocked(
+    std::unique_lock<std::mutex>& lk,
+    const std::chrono::time_point<Clock, Duration>* deadline) {
+  while (head_->next.load(std::memory_order_seq_cst) == nullptr) {
+    if (closed_.load(std::memory_order_seq_cst)) {
+      return QueueStatus::kClosed;
+    }
+    waiting_consumers_.fetch_add(1, std::memory_order_seq_cst);
+    if (head_->next.load(std::memory_order_seq_cst) == nullptr &&
+        !closed_.load(std::memory_order_seq_cst)) {
+      if (deadline == nullptr) {
+        data_cond_.wait(lk);
+      } else if (data_cond_.wait_until(lk, *deadline) ==
+                 std::cv_status::timeout) {
+        waiting_consumers_.fetch_sub(1, std::memory_order_relaxed);
+        if (head_->next.load(std::memory_order_acquire) != nullptr) {
+          return QueueStatus::kSuccess;
+        }
+        return closed_.load(std::memory_order_acquire)
+                   ? QueueStatus::kClosed
+                   : QueueStatus::kTimeout;
+      }
+    }
+    waiting_consumers_.fetch_sub(1, std::memory_order_relaxed);
+  }
+  return QueueStatus::kSuccess;
+}
+
+template <typename T>
+bool TwoLockQueue<T>::WaitAndPop(T& value) {
+  std::unique_lock<std::mutex> lk(head_mutex_);
+  if (WaitLocked(lk, static_cast<const Deadline*>(nullptr)) !=
+      QueueStatus::kSuccess) {
+    return false;
+  }
+  return PopLocked(value);
+}
+
+template <typename T>
+std::shared_ptr<T> TwoLockQueue<T>::WaitAndPop() {
+  std::shared_ptr<T> res;
+  std::unique_lock<std::mutex> lk(head_mutex_);
+  if (WaitLocked(lk, static_cast<const Deadline*>(nullptr)) ==
+      QueueStatus::kSuccess) {
+    PopSharedLocked(res);
+  }
+  return res;
+}
+
+template <typename T>
+template <typename Rep, typename Period>
+QueueStatus TwoLockQueue<T>::WaitAndPopFor(
+    T& value, const std::chrono::duration<Rep, Period>& timeout) {
+  return WaitAndPopUntil(value, std::chrono::steady_clock::now() + timeout);
+}
+
+template <typename T>
+template <typename Clock, typename Duration>
+QueueStatus TwoLockQueue<T>::WaitAndPopUntil(
+    T& value, const std::chrono::time_point<Clock, Duration>& deadline) {
+  std::unique_lock<std::mutex> lk(head_mutex_);
+  QueueStatus status = WaitLocked(lk, &deadline);
+  if (status == QueueStatus::kSuccess) {
+    PopLocked(value);
+  }
+  return status;
+}
+
+template <typename T>
+bool TwoLockQueue<T>::TryPop(T& value) {
+  std::lock_guard<std::mutex> lk(head_mutex_);
+  return PopLocked(value);
+}
+
+template <typename T>
+std::shared_ptr<T> TwoLockQueue<T>::TryPop() {
+  std::shared_ptr<T> res;
+  std::lock_guard<std::mutex> lk(head_mutex_);
+  PopSharedLocked(res);
+  return res;
+}
+
+template <typename T>
+std::shared_ptr<T> TwoLockQueue<T>::Front() {
+  std::lock_guard<std::mutex> lk(head_mutex_);
+  Node* next = head_->next.load(std::memory_order_acquire);
+  if (next == nullptr) {
+    return std::shared_ptr<T>();
+  }
+  return std::make_shared<T>(*next->Value());
+}
+
+template <typename T>
+std::shared_ptr<T> TwoLockQueue<T>::Back() {
+  // Lock order is always head, then tail
+  std::lock_guard<std::mutex> head_lk(head_mutex_);
+  std::lock_guard<std::mutex> tail_lk(tail_mutex_);
+  if (tail_ == head_) {
+    return std::shared_ptr<T>();
+  }
+  return std::make_shared<T>(*tail_->Value());
+}
+
+template <typename T>
+void TwoLockQueue<T>::Close() {
+  {
+    std::lock_guard<std::mutex> lk(tail_mutex_);
+    closed_.store(true, std::memory_order_seq_cst);
+  }
+  std::lock_guard<std::mutex> lk(head_mutex_);
+  data_cond_.notify_all();
+}
+
+template <typename T>
+void TwoLockQueue<T>::Clear() {
+  std::lock_guard<std::mutex> head_lk(head_mutex_);
+  std::lock_guard<std::mutex> tail_lk(tail_mutex_);
+  Node* node = head_->next.load(std::memory_order_relaxed);
+  while (node) {
+    Node* next = node->next.load(std::memory_order_relaxed);
+    node->Value()->~T();
+    RetireNode(node);
+    node = next;
+  }
+  head_->next.store(nullptr, std::memory_order_relaxed);
+  tail_ = head_;
+  size_.store(0, std::memory_order_relaxed);
+}
+
+template <typename T>
+size_t TwoLockQueue<T>::Size() const {
+  ptrdiff_t size = size_.load(std::memory_order_relaxed);
+  return size > 0 ? static_cast<size_t>(size) : 0;
+}
+
+}  // namespace Utils
+
+#endif  // UTILS_TWO_LOCK_QUEUE_H_
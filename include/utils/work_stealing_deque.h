@@ -0,0 +1,192 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Lock-free work stealing deque.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#ifndef UTILS_WORK_STEALING_DEQUE_H_
+#define UTILS_WORK_STEALING_DEQUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "lock_free_common.h"
+
+namespace Utils {
+
+/**
+ * Chase-Lev deque in the formulation of Le et al. for C11 atomics. One owner
+ * thread pushes and pops at the bottom, popping is LIFO and only contends
+ * with thieves for the last element. Any thread may steal from the top with
+ * a CAS. The circular buffer doubles when full; replaced buffers may still be
+ * read by a thief and are kept until the deque is destroyed, which costs at
+ * most as much as the live buffer.
+ *
+ * Elements are read before the CAS that claims them, so T must be trivially
+ * copyable, typically a pointer or an index.
+ */
+template <typename T>
+class WorkStealingDeque {
+ public:
+  static_assert(std::is_trivially_copyable<T>::value,
+                "WorkStealingDeque requires a trivially copyable T");
+
+  explicit WorkStealingDeque(size_t capacity = 64);
+
+  ~WorkStealingDeque();
+
+  WorkStealingDeque(const WorkStealingDeque& other) = delete;
+  WorkStealingDeque& operator=(const WorkStealingDeque& other) = delete;
+
+  /**
+   * Owner only.
+   */
+  void Push(T value);
+
+  /**
+   * Owner only, pops the most recently pushed element.
+   * @return false if the deque is empty
+   */
+  bool TryPop(T& value);
+
+  /**
+   * Any thread, takes the oldest element.
+   * @return false if the deque is empty or another thread won the race
+   */
+  bool TrySteal(T& value);
+
+  /**
+   * Approximate under concurrent access.
+   */
+  size_t Size() const;
+
+  bool IsEmpty() const { return Size() == 0; }
+
+ private:
+  struct Buffer {
+    explicit Buffer(int64_t capacity)
+        : mask(capacity - 1), items(new std::atomic<T>[capacity]) {}
+
+    ~Buffer() { delete[] items; }
+
+    T Get(int64_t index) const {
+      return items[index & mask].load(std::memory_order_relaxed);
+    }
+
+    void Put(int64_t index, T value) {
+      items[index & mask].store(value, std::memory_order_relaxed);
+    }
+
+    int64_t Capacity() const { return mask + 1; }
+
+    const int64_t mask;
+    std::atomic<T>* const items;
+  };
+
+  Buffer* Grow(Buffer* buffer, int64_t bottom, int64_t top);
+
+  // Thieves write 'top_', the owner writes 'bottom_' and 'buffer_'
+  std::atomic<int64_t> top_{0};
+  char padding0_[kCacheLineSize - sizeof(std::atomic<int64_t>)];
+  std::atomic<int64_t> bottom_{0};
+  std::atomic<Buffer*> buffer_;
+  char padding1_[kCacheLineSize];
+
+  // Owner only, replaced buffers kept alive for late thieves
+  std::vector<Buffer*> retired_;
+};
+
+template <typename T>
+WorkStealingDeque<T>::WorkStealingDeque(size_t capacity)
+    : buffer_(new Buffer(static_cast<int64_t>(RoundUpPowerOfTwo(capacity)))) {}
+
+template <typename T>
+WorkStealingDeque<T>::~WorkStealingDeque() {
+  delete buffer_.load(std::memory_order_relaxed);
+  for (auto buffer : retired_) {
+    delete buffer;
+  }
+}
+
+template <typename T>
+inline void WorkStealingDeque<T>::Push(T value) {
+  int64_t b = bottom_.load(std::memory_order_relaxed);
+  int64_t t = top_.load(std::memory_order_acquire);
+  Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+  if (b - t > buffer->Capacity() - 1) {
+    buffer = Grow(buffer, b, t);
+  }
+  buffer->Put(b, value);
+  bottom_.store(b + 1, std::memory_order_release);
+}
+
+template <typename T>
+inline bool WorkStealingDeque<T>::TryPop(T& value) {
+  int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+  Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+  // Every store to 'bottom_' is a release, so a thief that reads any of
+  // them also sees the elements pushed before it; on x86 it is a plain mov
+  bottom_.store(b, std::memory_order_release);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  int64_t t = top_.load(std::memory_order_relaxed);
+  if (t > b) {
+    // Empty, restore the bottom
+    bottom_.store(b + 1, std::memory_order_release);
+    return false;
+  }
+  value = buffer->Get(b);
+  if (t == b) {
+    // Last element, race the thieves for it
+    bool won = top_.compare_exchange_strong(t, t + 1,
+                                            std::memory_order_seq_cst,
+                                            std::memory_order_relaxed);
+    bottom_.store(b + 1, std::memory_order_release);
+    return won;
+  }
+  return true;
+}
+
+template <typename T>
+inline bool WorkStealingDeque<T>::TrySteal(T& value) {
+  int64_t t = top_.load(std::memory_order_acquire);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  int64_t b = bottom_.load(std::memory_order_acquire);
+  if (t >= b) {
+    return false;
+  }
+  Buffer* buffer = buffer_.load(std::memory_order_acquire);
+  T item = buffer->Get(t);
+  if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                    std::memory_order_relaxed)) {
+    return false;
+  }
+  value = item;
+  return true;
+}
+
+template <typename T>
+size_t WorkStealingDeque<T>::Size() const {
+  int64_t b = bottom_.load(std::memory_order_relaxed);
+  int64_t t = top_.load(std::memory_order_relaxed);
+  return b > t ? static_cast<size_t>(b - t) : 0;
+}
+
+template <typename T>
+typename WorkStealingDeque<T>::Buffer* WorkStealingDeque<T>::Grow(
+    Buffer* buffer, int64_t bottom, int64_t top) {
+  Buffer* bigger = new Buffer(buffer->Capacity() * 2);
+  for (int64_t i = top; i < bottom; i++) {
+    bigger->Put(i, buffer->Get(i));
+  }
+  retired_.push_back(buffer);
+  buffer_.store(bigger, std::memory_order_release);
+  return bigger;
+}
+
+}  // namespace Utils
+
+#endif  // UTILS_WORK_STEALING_DEQUE_H_
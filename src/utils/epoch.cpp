@@ -0,0 +1,179 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Epoch based memory reclamation for lock-free containers.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#include "epoch.h"
+
+#include <thread>
+
+namespace Utils {
+
+thread_local Epoch::ThreadHandle Epoch::handle_;
+
+Epoch &Epoch::Instance() {
+  // Intentionally leaked, threads may exit after static destruction
+  static Epoch *instance = new Epoch();
+  return *instance;
+}
+
+Epoch::Record *Epoch::LocalRecord() {
+  if (handle_.record == nullptr) {
+    handle_.record = Instance().AcquireRecord();
+  }
+  return handle_.record;
+}
+
+void Epoch::Enter() {
+  Record *record = LocalRecord();
+  if (record->nesting++ != 0) {
+    return;
+  }
+  uint64_t epoch = Instance().global_epoch_.load(std::memory_order_relaxed);
+  record->state.store((epoch << 1) | 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+void Epoch::Exit() {
+  Record *record = handle_.record;
+  if (record == nullptr || record->nesting == 0) {
+    return;
+  }
+  if (--record->nesting == 0) {
+    uint64_t state = record->state.load(std::memory_order_relaxed);
+    record->state.store(state & ~static_cast<uint64_t>(1),
+                        std::memory_order_release);
+  }
+}
+
+void Epoch::Retire(void *ptr, Reclaimer reclaim, void *ctx) {
+  if (ptr == nullptr) {
+    return;
+  }
+  Record *record = LocalRecord();
+  Retired item;
+  item.ptr = ptr;
+  item.reclaim = reclaim;
+  item.ctx = ctx;
+  item.epoch = Instance().global_epoch_.load(std::memory_order_seq_cst);
+  record->retired.push_back(item);
+
+  if (++record->retired_since_collect >= kCollectThreshold) {
+    record->retired_since_collect = 0;
+    Collect();
+  }
+}
+
+size_t Epoch::Collect() {
+  Epoch &self = Instance();
+  Record *record = LocalRecord();
+  self.TryAdvance();
+  size_t reclaimed = self.Reclaim(&record->retired);
+  reclaimed += self.CollectOrphans();
+  return reclaimed;
+}
+
+void Epoch::Synchronize() {
+  while (true) {
+    Collect();
+    if (GetPendingCount() == 0) {
+      break;
+    }
+    std::this_thread::yield();
+  }
+}
+
+uint64_t Epoch::GetGlobalEpoch() {
+  return Instance().global_epoch_.load(std::memory_order_relaxed);
+}
+
+size_t Epoch::GetPendingCount() { return LocalRecord()->retired.size(); }
+
+Epoch::Record *Epoch::AcquireRecord() {
+  // Reuse a record released by an exited thread first
+  for (Record *record = records_.load(std::memory_order_acquire); record;
+       record = record->next) {
+    bool expected = false;
+    if (!record->in_use.load(std::memory_order_relaxed) &&
+        record->in_use.compare_exchange_strong(expected, true,
+                                               std::memory_order_acquire)) {
+      return record;
+    }
+  }
+
+  Record *record = new Record();
+  record->in_use.store(true, std::memory_order_relaxed);
+  Record *head = records_.load(std::memory_order_relaxed);
+  do {
+    record->next = head;
+  } while (!records_.compare_exchange_weak(head, record,
+                                           std::memory_order_release,
+                                           std::memory_order_relaxed));
+  return record;
+}
+
+void Epoch::ReleaseRecord(Record *record) {
+  if (!record->retired.empty()) {
+    std::lock_guard<std::mutex> lck(orphan_mutex_);
+    orphans_.insert(orphans_.end(), record->retired.begin(),
+                    record->retired.end());
+  }
+  record->retired.clear();
+  record->retired.shrink_to_fit();
+  record->retired_since_collect = 0;
+  record->nesting = 0;
+  record->state.store(0, std::memory_order_release);
+  record->in_use.store(false, std::memory_order_release);
+}
+
+bool Epoch::TryAdvance() {
+  uint64_t epoch = global_epoch_.load(std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  for (Record *record = records_.load(std::memory_order_acquire); record;
+       record = record->next) {
+    uint64_t state = record->state.load(std::memory_order_relaxed);
+    if ((state & 1) && (state >> 1) != epoch) {
+      return false;
+    }
+  }
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return global_epoch_.compare_exchange_strong(
+      epoch, epoch + 1, std::memory_order_release, std::memory_order_relaxed);
+}
+
+size_t Epoch::Reclaim(std::vector<Retired> *retired) {
+  uint64_t epoch = global_epoch_.load(std::memory_order_acquire);
+  size_t kept = 0;
+  size_t reclaimed = 0;
+  for (size_t i = 0; i < retired->size(); i++) {
+    Retired &item = (*retired)[i];
+    if (item.epoch + 2 <= epoch) {
+      item.reclaim(item.ptr, item.ctx);
+      reclaimed++;
+    } else {
+      (*retired)[kept++] = item;
+    }
+  }
+  retired->resize(kept);
+  return reclaimed;
+}
+
+size_t Epoch::CollectOrphans() {
+  std::unique_lock<std::mutex> lck(orphan_mutex_, std::try_to_lock);
+  if (!lck.owns_lock() || orphans_.empty()) {
+    return 0;
+  }
+  return Reclaim(&orphans_);
+}
+
+Epoch::ThreadHandle::~ThreadHandle() {
+  if (record != nullptr) {
+    Instance().ReleaseRecord(record);
+    record = nullptr;
+  }
+}
+
+}  // namespace Utils
@@ -0,0 +1,63 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief QueueNotifier signalling a Linux eventfd.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#include "event_fd_notifier.h"
+
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#endif
+
+namespace Utils {
+
+#if defined(__linux__)
+
+EventFdNotifier::EventFdNotifier() {
+  fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+}
+
+EventFdNotifier::~EventFdNotifier() {
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+void EventFdNotifier::Notify() {
+  if (fd_ < 0) {
+    return;
+  }
+  uint64_t one = 1;
+  // EAGAIN means the counter is saturated, the fd is readable anyway
+  while (write(fd_, &one, sizeof(one)) < 0 && errno == EINTR) {
+  }
+}
+
+void EventFdNotifier::Consume() {
+  if (fd_ < 0) {
+    return;
+  }
+  uint64_t count = 0;
+  while (read(fd_, &count, sizeof(count)) < 0 && errno == EINTR) {
+  }
+}
+
+#else
+
+EventFdNotifier::EventFdNotifier() {}
+
+EventFdNotifier::~EventFdNotifier() {}
+
+void EventFdNotifier::Notify() {}
+
+void EventFdNotifier::Consume() {}
+
+#endif
+
+}  // namespace Utils
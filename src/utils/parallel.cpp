@@ -0,0 +1,19 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Fork-join parallel algorithms on top of ThreadPool.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#include "parallel.h"
+
+namespace Utils {
+
+ThreadPool &GetDefaultThreadPool() {
+  // Intentionally leaked, tasks may still be posted during static
+  // destruction
+  static ThreadPool *pool = new ThreadPool();
+  return *pool;
+}
+
+}  // namespace Utils
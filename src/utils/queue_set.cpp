@@ -0,0 +1,84 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Block on several thread safe queues at once.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#include "queue_set.h"
+
+namespace Utils {
+
+QueueSet::QueueSet(SelectPolicy policy) : policy_(policy) {}
+
+QueueSet::~QueueSet() {
+  for (auto &member : members_) {
+    member->detach();
+  }
+}
+
+bool QueueSet::Select(size_t &index) {
+  return Wait(index, nullptr) == QueueStatus::kSuccess;
+}
+
+QueueStatus QueueSet::SelectUntil(
+    size_t &index, const std::chrono::steady_clock::time_point &deadline) {
+  return Wait(index, &deadline);
+}
+
+bool QueueSet::TrySelect(size_t &index) {
+  std::lock_guard<std::mutex> lk(mut_);
+  return Scan(index) == QueueStatus::kSuccess;
+}
+
+size_t QueueSet::Size() const {
+  std::lock_guard<std::mutex> lk(mut_);
+  return members_.size();
+}
+
+void QueueSet::Signal() {
+  std::lock_guard<std::mutex> lk(mut_);
+  signals_++;
+  cond_.notify_all();
+}
+
+QueueStatus QueueSet::Scan(size_t &index) {
+  size_t count = members_.size();
+  size_t start = policy_ == SelectPolicy::kRoundRobin ? next_ : 0;
+  bool all_closed = count > 0;
+  for (size_t i = 0; i < count; i++) {
+    size_t candidate = (start + i) % count;
+    Member &member = *members_[candidate];
+    // Closed is read first, a push can not follow it
+    bool closed = member.is_closed();
+    if (member.has_data()) {
+      index = candidate;
+      next_ = candidate + 1;
+      return QueueStatus::kSuccess;
+    }
+    all_closed = all_closed && closed;
+  }
+  return all_closed ? QueueStatus::kClosed : QueueStatus::kTimeout;
+}
+
+QueueStatus QueueSet::Wait(
+    size_t &index, const std::chrono::steady_clock::time_point *deadline) {
+  std::unique_lock<std::mutex> lk(mut_);
+  while (true) {
+    // A member turning ready during the scan signals under 'mut_', so it is
+    // seen either here or as a new signal below
+    QueueStatus status = Scan(index);
+    if (status != QueueStatus::kTimeout) {
+      return status;
+    }
+    uint64_t signals = signals_;
+    auto signalled = [this, signals] { return signals_ != signals; };
+    if (deadline == nullptr) {
+      cond_.wait(lk, signalled);
+    } else if (!cond_.wait_until(lk, *deadline, signalled)) {
+      return QueueStatus::kTimeout;
+    }
+  }
+}
+
+}  // namespace Utils
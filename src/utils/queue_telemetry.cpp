@@ -0,0 +1,79 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Opt-in instrumentation policies for ThreadSafeQueue.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#include "queue_telemetry.h"
+
+#include "json.hpp"
+
+namespace Utils {
+
+QueueTelemetry::QueueTelemetry() : created_at_(Now()) {
+  for (size_t i = 0; i < kBuckets; i++) {
+    depth_histogram_[i] = 0;
+    sojourn_histogram_[i] = 0;
+  }
+}
+
+QueueTelemetrySnapshot QueueTelemetry::Snapshot(size_t depth) const {
+  QueueTelemetrySnapshot snapshot;
+  snapshot.enabled = true;
+  snapshot.elapsed_seconds = (Now() - created_at_) / 1e9;
+
+  snapshot.enqueued = enqueued_;
+  snapshot.dequeued = dequeued_;
+  snapshot.discarded = discarded_;
+  if (snapshot.elapsed_seconds > 0) {
+    snapshot.enqueue_rate = enqueued_ / snapshot.elapsed_seconds;
+    snapshot.dequeue_rate = dequeued_ / snapshot.elapsed_seconds;
+  }
+
+  snapshot.depth = depth;
+  snapshot.max_depth = max_depth_;
+  snapshot.depth_histogram.assign(depth_histogram_,
+                                  depth_histogram_ + kBuckets);
+
+  snapshot.sojourn_count = sojourn_count_;
+  if (sojourn_count_ > 0) {
+    snapshot.sojourn_mean_us = sojourn_total_ns_ / 1e3 / sojourn_count_;
+  }
+  snapshot.sojourn_max_us = sojourn_max_ns_ / 1e3;
+  snapshot.sojourn_histogram_us.assign(sojourn_histogram_,
+                                       sojourn_histogram_ + kBuckets);
+
+  snapshot.consumer_waits = consumer_waits_;
+  if (consumer_waits_ > 0) {
+    snapshot.consumer_wait_mean_us =
+        consumer_wait_total_ns_ / 1e3 / consumer_waits_;
+  }
+  snapshot.consumer_wait_max_us = consumer_wait_max_ns_ / 1e3;
+  return snapshot;
+}
+
+std::string TelemetryToJson(const QueueTelemetrySnapshot &snapshot,
+                            int indent) {
+  nlohmann::json json;
+  json["enabled"] = snapshot.enabled;
+  json["elapsed_seconds"] = snapshot.elapsed_seconds;
+  json["enqueued"] = snapshot.enqueued;
+  json["dequeued"] = snapshot.dequeued;
+  json["discarded"] = snapshot.discarded;
+  json["enqueue_rate"] = snapshot.enqueue_rate;
+  json["dequeue_rate"] = snapshot.dequeue_rate;
+  json["depth"] = snapshot.depth;
+  json["max_depth"] = snapshot.max_depth;
+  json["depth_histogram"] = snapshot.depth_histogram;
+  json["sojourn"] = {{"count", snapshot.sojourn_count},
+                     {"mean_us", snapshot.sojourn_mean_us},
+                     {"max_us", snapshot.sojourn_max_us},
+                     {"histogram_us", snapshot.sojourn_histogram_us}};
+  json["consumer_wait"] = {{"count", snapshot.consumer_waits},
+                           {"mean_us", snapshot.consumer_wait_mean_us},
+                           {"max_us", snapshot.consumer_wait_max_us}};
+  return json.dump(indent);
+}
+
+}  // namespace Utils
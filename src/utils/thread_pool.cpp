@@ -0,0 +1,197 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Work stealing thread pool.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#include "thread_pool.h"
+
+namespace Utils {
+
+namespace {
+
+// Identifies the pool and worker the current thread belongs to
+thread_local const ThreadPool *current_pool = nullptr;
+thread_local int current_index = -1;
+
+}  // namespace
+
+ThreadPool::ThreadPool(size_t thread_count) {
+  if (thread_count == 0) {
+    thread_count = std::thread::hardware_concurrency();
+    if (thread_count == 0) {
+      thread_count = 1;
+    }
+  }
+  for (size_t i = 0; i < thread_count; i++) {
+    workers_.emplace_back(new Worker());
+  }
+  // Start threads only once every deque exists, they steal from each other
+  for (size_t i = 0; i < thread_count; i++) {
+    workers_[i]->thread =
+        std::thread(&ThreadPool::WorkerLoop, this, static_cast<int>(i));
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  Shutdown();
+}
+
+bool ThreadPool::Post(Task task) {
+  std::vector<TaskNode *> nodes(1, new TaskNode(std::move(task)));
+  return Enqueue(nodes);
+}
+
+bool ThreadPool::Enqueue(std::vector<TaskNode *> &nodes) {
+  int64_t count = static_cast<int64_t>(nodes.size());
+  // Raised first so a stopping worker can not exit while the tasks are in
+  // flight
+  pending_.fetch_add(count, std::memory_order_seq_cst);
+
+  int index = CurrentWorkerIndex();
+  if (index >= 0) {
+    // Worker local fast path, no lock
+    for (auto node : nodes) {
+      workers_[index]->deque.Push(node);
+    }
+  } else if (!injected_.PushRange(nodes.begin(), nodes.end())) {
+    // Only fails once Shutdown() closed the injection queue
+    pending_.fetch_sub(count, std::memory_order_seq_cst);
+    for (auto node : nodes) {
+      delete node;
+    }
+    return false;
+  }
+  WakeWorkers(nodes.size());
+  return true;
+}
+
+void ThreadPool::WakeWorkers(size_t count) {
+  // Pairs with WaitForWork: either the sleeper sees 'pending_' raised, or
+  // this load sees the sleeper
+  if (sleepers_.load(std::memory_order_seq_cst) == 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lk(sleep_mutex_);
+  if (count == 1) {
+    sleep_cond_.notify_one();
+  } else {
+    sleep_cond_.notify_all();
+  }
+}
+
+bool ThreadPool::RunPendingTask() {
+  TaskNode *node = FindTask(CurrentWorkerIndex());
+  if (node == nullptr) {
+    return false;
+  }
+  RunTask(node);
+  return true;
+}
+
+bool ThreadPool::RunLocalTask(int index) {
+  TaskNode *node = nullptr;
+  if (!workers_[index]->deque.TryPop(node)) {
+    return false;
+  }
+  pending_.fetch_sub(1, std::memory_order_relaxed);
+  RunTask(node);
+  return true;
+}
+
+ThreadPool::TaskNode *ThreadPool::FindTask(int index) {
+  TaskNode *node = nullptr;
+  if ((index >= 0 && workers_[index]->deque.TryPop(node)) ||
+      injected_.TryPop(node) || (node = Steal(index)) != nullptr) {
+    pending_.fetch_sub(1, std::memory_order_relaxed);
+    return node;
+  }
+  return nullptr;
+}
+
+ThreadPool::TaskNode *ThreadPool::Steal(int index) {
+  size_t count = workers_.size();
+  size_t start = index >= 0 ? static_cast<size_t>(index) + 1 : 0;
+  TaskNode *node = nullptr;
+  for (size_t i = 0; i < count; i++) {
+    size_t victim = (start + i) % count;
+    if (static_cast<int>(victim) != index &&
+        workers_[victim]->deque.TrySteal(node)) {
+      return node;
+    }
+  }
+  return nullptr;
+}
+
+void ThreadPool::RunTask(TaskNode *node) {
+  node->task();
+  delete node;
+}
+
+void ThreadPool::WorkerLoop(int index) {
+  current_pool = this;
+  current_index = index;
+
+  Backoff backoff;
+  int idle_rounds = 0;
+  while (true) {
+    TaskNode *node = FindTask(index);
+    if (node) {
+      RunTask(node);
+      idle_rounds = 0;
+      backoff.Reset();
+    } else if (idle_rounds++ < kSpinRounds) {
+      backoff.Pause();
+    } else if (!WaitForWork()) {
+      break;
+    } else {
+      idle_rounds = 0;
+      backoff.Reset();
+    }
+  }
+
+  current_pool = nullptr;
+  current_index = -1;
+}
+
+bool ThreadPool::WaitForWork() {
+  std::unique_lock<std::mutex> lk(sleep_mutex_);
+  sleepers_.fetch_add(1, std::memory_order_seq_cst);
+  while (pending_.load(std::memory_order_seq_cst) <= 0 &&
+         !stopping_.load(std::memory_order_seq_cst)) {
+    sleep_cond_.wait(lk);
+  }
+  sleepers_.fetch_sub(1, std::memory_order_relaxed);
+  return pending_.load(std::memory_order_seq_cst) > 0 ||
+         !stopping_.load(std::memory_order_relaxed);
+}
+
+void ThreadPool::Shutdown() {
+  std::lock_guard<std::mutex> shutdown_lk(shutdown_mutex_);
+  if (stopping_.load(std::memory_order_acquire)) {
+    return;
+  }
+  injected_.Close();
+  {
+    std::lock_guard<std::mutex> lk(sleep_mutex_);
+    stopping_.store(true, std::memory_order_seq_cst);
+    sleep_cond_.notify_all();
+  }
+  for (auto &worker : workers_) {
+    if (worker->thread.joinable()) {
+      worker->thread.join();
+    }
+  }
+}
+
+size_t ThreadPool::GetPendingCount() const {
+  int64_t pending = pending_.load(std::memory_order_relaxed);
+  return pending > 0 ? static_cast<size_t>(pending) : 0;
+}
+
+int ThreadPool::CurrentWorkerIndex() const {
+  return current_pool == this ? current_index : -1;
+}
+
+}  // namespace Utils
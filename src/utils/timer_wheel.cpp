@@ -0,0 +1,305 @@
+/**
+ * Copyright 2019 all rights reserved
+ * @brief Hierarchical timing wheel for large numbers of timeouts.
+ * @date 19/Oct/2026
+ * @author jin.ma
+ */
+
+#include "timer_wheel.h"
+
+#include <chrono>
+#include <utility>
+
+namespace Utils {
+
+const TimerWheel::TimerId TimerWheel::kInvalidTimer;
+
+TimerWheel::TimerWheel(TimeStamp tick_ms, TimeStamp now)
+    : tick_ms_(tick_ms > 0 ? tick_ms : 1), origin_(now) {
+  for (size_t i = 0; i <= kOverdueSlot; i++) {
+    heads_[i] = kNil;
+  }
+}
+
+TimerWheel::TimerId TimerWheel::Schedule(TimeStamp delay_ms,
+                                         Callback callback) {
+  return ScheduleAt(GetTimeStamp() + delay_ms, std::move(callback));
+}
+
+TimerWheel::TimerId TimerWheel::ScheduleAt(TimeStamp when,
+                                           Callback callback) {
+  // Rounded up, a timer never fires before 'when'
+  TimeStamp offset = when - origin_;
+  uint64_t expiry = offset > 0 ? (offset + tick_ms_ - 1) / tick_ms_ : 0;
+
+  uint32_t index = Allocate();
+  Node &node = nodes_[index];
+  node.callback = std::move(callback);
+  node.expiry = expiry;
+  Link(index);
+  size_++;
+  return (static_cast<TimerId>(node.generation) << 32) | index;
+}
+
+bool TimerWheel::Cancel(TimerId id) {
+  uint32_t index = static_cast<uint32_t>(id);
+  uint32_t generation = static_cast<uint32_t>(id >> 32);
+  if (index >= nodes_.size()) {
+    return false;
+  }
+  Node &node = nodes_[index];
+  if (node.slot == kNil || node.generation != generation) {
+    return false;
+  }
+  Unlink(index);
+  Release(index);
+  size_--;
+  return true;
+}
+
+size_t TimerWheel::Advance(TimeStamp now) {
+  std::vector<Callback> expired;
+  size_t fired = Advance(now, expired);
+  for (auto &callback : expired) {
+    callback();
+  }
+  return fired;
+}
+
+size_t TimerWheel::Advance(TimeStamp now, std::vector<Callback> &expired) {
+  TimeStamp offset = now - origin_;
+  if (offset < 0) {
+    return 0;
+  }
+  uint64_t target = static_cast<uint64_t>(offset / tick_ms_);
+  size_t fired = FireSlot(kOverdueSlot, expired);
+  while (current_tick_ <= target && size_ > 0) {
+    uint64_t tick = current_tick_;
+    // Refill lower levels from every level that starts a new turn, top down
+    // since a node cascaded from level n may land in the slot of level n-1
+    // being refilled next
+    size_t level = 0;
+    while (level + 1 < kLevels &&
+           (tick & ((uint64_t(1) << ((level + 1) * kSlotBits)) - 1)) == 0) {
+      level++;
+    }
+    for (; level > 0; level--) {
+      Cascade(level, tick);
+    }
+
+    current_tick_++;
+    fired += FireSlot(static_cast<uint32_t>(tick & kSlotMask), expired);
+  }
+  // Nothing pending, skip the idle ticks
+  if (current_tick_ <= target) {
+    current_tick_ = target + 1;
+  }
+  return fired;
+}
+
+TimeStamp TimerWheel::GetNextExpiry() const {
+  if (size_ == 0) {
+    return -1;
+  }
+  if (heads_[kOverdueSlot] != kNil) {
+    return origin_ + static_cast<TimeStamp>(current_tick_ - 1) * tick_ms_;
+  }
+  // Level 0 only holds the current turn, anything further waits for the
+  // cascade at the start of the next one
+  uint64_t tick = current_tick_;
+  while ((tick & kSlotMask) != 0 && heads_[tick & kSlotMask] == kNil) {
+    tick++;
+  }
+  return origin_ + static_cast<TimeStamp>(tick) * tick_ms_;
+}
+
+uint32_t TimerWheel::Allocate() {
+  if (free_head_ != kNil) {
+    uint32_t index = free_head_;
+    free_head_ = nodes_[index].next;
+    return index;
+  }
+  nodes_.emplace_back();
+  return static_cast<uint32_t>(nodes_.size() - 1);
+}
+
+void TimerWheel::Release(uint32_t index) {
+  Node &node = nodes_[index];
+  node.callback = nullptr;
+  node.slot = kNil;
+  node.prev = kNil;
+  node.generation++;
+  if (node.generation == 0) {
+    node.generation = 1;
+  }
+  node.next = free_head_;
+  free_head_ = index;
+}
+
+void TimerWheel::Link(uint32_t index) {
+  Node &node = nodes_[index];
+  uint64_t expiry = node.expiry;
+  if (expiry < current_tick_) {
+    LinkToSlot(index, kOverdueSlot);
+    return;
+  }
+  uint64_t diff = expiry ^ current_tick_;
+  if ((diff >> (kLevels * kSlotBits)) != 0) {
+    // Last tick of the current top level turn
+    expiry = current_tick_ | ((uint64_t(1) << (kLevels * kSlotBits)) - 1);
+    diff = expiry ^ current_tick_;
+  }
+  // The highest digit in which expiry and now differ picks the level
+  size_t level = 0;
+  while ((diff >> ((level + 1) * kSlotBits)) != 0) {
+    level++;
+  }
+  LinkToSlot(index, static_cast<uint32_t>(
+                        level * kSlots +
+                        ((expiry >> (level * kSlotBits)) & kSlotMask)));
+}
+
+void TimerWheel::LinkToSlot(uint32_t index, uint32_t slot) {
+  Node &node = nodes_[index];
+  node.slot = slot;
+  node.prev = kNil;
+  node.next = heads_[slot];
+  if (node.next != kNil) {
+    nodes_[node.next].prev = index;
+  }
+  heads_[slot] = index;
+}
+
+void TimerWheel::Unlink(uint32_t index) {
+  Node &node = nodes_[index];
+  if (node.prev != kNil) {
+    nodes_[node.prev].next = node.next;
+  } else {
+    heads_[node.slot] = node.next;
+  }
+  if (node.next != kNil) {
+    nodes_[node.next].prev = node.prev;
+  }
+}
+
+size_t TimerWheel::FireSlot(uint32_t slot, std::vector<Callback> &expired) {
+  uint32_t index = heads_[slot];
+  heads_[slot] = kNil;
+  size_t fired = 0;
+  while (index != kNil) {
+    Node &node = nodes_[index];
+    uint32_t next = node.next;
+    if (node.expiry >= current_tick_) {
+      // Parked beyond the wheel span
+      Link(index);
+    } else {
+      expired.push_back(std::move(node.callback));
+      Release(index);
+      size_--;
+      fired++;
+    }
+    index = next;
+  }
+  return fired;
+}
+
+void TimerWheel::Cascade(size_t level, uint64_t tick) {
+  uint32_t slot = static_cast<uint32_t>(
+      level * kSlots + ((tick >> (level * kSlotBits)) & kSlotMask));
+  uint32_t index = heads_[slot];
+  heads_[slot] = kNil;
+  while (index != kNil) {
+    uint32_t next = nodes_[index].next;
+    Link(index);
+    index = next;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+ThreadSafeTimerWheel::ThreadSafeTimerWheel(TimeStamp tick_ms)
+    : wheel_(tick_ms) {}
+
+ThreadSafeTimerWheel::TimerId ThreadSafeTimerWheel::Schedule(
+    TimeStamp delay_ms, Callback callback) {
+  return ScheduleAt(GetTimeStamp() + delay_ms, std::move(callback));
+}
+
+ThreadSafeTimerWheel::TimerId ThreadSafeTimerWheel::ScheduleAt(
+    TimeStamp when, Callback callback) {
+  std::unique_lock<std::mutex> lk(mut_);
+  TimerId id = wheel_.ScheduleAt(when, std::move(callback));
+  // Only a timer due before the planned wake-up needs Run() to re-plan
+  bool wake = sleeping_ && (wake_at_ < 0 || when < wake_at_);
+  lk.unlock();
+  if (wake) {
+    cond_.notify_one();
+  }
+  return id;
+}
+
+bool ThreadSafeTimerWheel::Cancel(TimerId id) {
+  std::lock_guard<std::mutex> lk(mut_);
+  return wheel_.Cancel(id);
+}
+
+size_t ThreadSafeTimerWheel::Advance(TimeStamp now) {
+  std::vector<Callback> batch;
+  size_t fired;
+  {
+    std::lock_guard<std::mutex> lk(mut_);
+    fired = wheel_.Advance(now, batch);
+  }
+  RunBatch(batch);
+  return fired;
+}
+
+TimeStamp ThreadSafeTimerWheel::GetNextExpiry() const {
+  std::lock_guard<std::mutex> lk(mut_);
+  return wheel_.GetNextExpiry();
+}
+
+void ThreadSafeTimerWheel::Run() {
+  std::vector<Callback> batch;
+  std::unique_lock<std::mutex> lk(mut_);
+  while (!stopped_) {
+    TimeStamp now = GetTimeStamp();
+    wheel_.Advance(now, batch);
+    if (!batch.empty()) {
+      lk.unlock();
+      RunBatch(batch);
+      lk.lock();
+      continue;
+    }
+
+    wake_at_ = wheel_.GetNextExpiry();
+    sleeping_ = true;
+    if (wake_at_ < 0) {
+      cond_.wait(lk);
+    } else if (wake_at_ > now) {
+      cond_.wait_for(lk, std::chrono::milliseconds(wake_at_ - now));
+    }
+    sleeping_ = false;
+  }
+}
+
+void ThreadSafeTimerWheel::Stop() {
+  {
+    std::lock_guard<std::mutex> lk(mut_);
+    stopped_ = true;
+  }
+  cond_.notify_all();
+}
+
+size_t ThreadSafeTimerWheel::Size() const {
+  std::lock_guard<std::mutex> lk(mut_);
+  return wheel_.Size();
+}
+
+void ThreadSafeTimerWheel::RunBatch(std::vector<Callback> &batch) {
+  for (auto &callback : batch) {
+    callback();
+  }
+  batch.clear();
+}
+
+}  // namespace Utils